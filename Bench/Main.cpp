@@ -0,0 +1,972 @@
+/*
+  ==============================================================================
+
+    Benchmarks for the drone's DSP building blocks, both synths and the whole processBlock.
+    Runs headless, prints CPU time per block for each stage under test.
+
+    usage: drone_bench [--json results.json]
+           --json also writes every timing to a file, to compare between releases
+    exits 1 if the open editor's telemetry slows processBlock past its bounds (see telemetryMeanRatio)
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../Source/modFilter.h"
+#include "../Source/osc.h"
+#include "../Source/oscBank.h"
+#include "../Source/modNoise.h"
+#include "../Source/effects.h"
+#include "../Source/fdnReverb.h"
+#include "../Source/thickSynth.h"
+#include "../Source/chasingSynth.h"
+#include "../Source/chaseSwarm.h"
+#include "../Source/PluginProcessor.h"
+
+//==============================================================================
+// ---- BENCHMARK HELPERS ---- //
+
+static const double benchSR = 48000.0; // sample rate used for all benchmarks
+static const int benchBlock = 512; // samples per block
+static const int benchBlocks = 20000; // blocks timed per run
+
+// keeps the optimiser from throwing away benchmark results
+static volatile float benchSink = 0.0f;
+
+// cutoff and resonance LFO's, same ranges as ThickSynth
+struct FilterLFO
+{
+    float cutoff(int n)
+    {
+        return std::sin(phase(n) * juce::MathConstants<float>::twoPi) * 1200.0f + 1850.0f;
+    }
+
+    float resonance(int n)
+    {
+        return std::sin(phase(n) * 0.08f * juce::MathConstants<float>::twoPi) + 5.0f;
+    }
+
+    float phase(int n)
+    {
+        return (float)std::fmod(n * 0.0612 / benchSR, 1.0);
+    }
+};
+
+// every timing so far, for --json
+static juce::Array<juce::var> benchResults;
+static juce::String benchGroup; // heading results are filed under
+
+// prints a heading, results after it are filed under it
+static void section(const juce::String& title)
+{
+    benchGroup = title;
+    std::cout << "\n" << title << "\n";
+}
+
+// adds a result for --json, callers add whatever else describes it
+static juce::DynamicObject* record(const juce::String& name)
+{
+    auto* result = new juce::DynamicObject();
+    result->setProperty("group", benchGroup);
+    result->setProperty("name", name);
+    benchResults.add(juce::var(result));
+    return result;
+}
+
+// prints ns per block and ns per sample for a timed run
+static void report(const juce::String& name, double seconds, int blockSize = benchBlock, int numBlocks = benchBlocks, double SR = benchSR)
+{
+    double nsPerBlock = seconds * 1.0e9 / numBlocks;
+
+    std::cout << name.paddedRight(' ', 36)
+              << juce::String(nsPerBlock, 1).paddedLeft(' ', 12) << " ns/block"
+              << juce::String(nsPerBlock / blockSize, 2).paddedLeft(' ', 10) << " ns/sample\n";
+
+    auto* result = record(name);
+    result->setProperty("ns_per_sample", nsPerBlock / blockSize);
+    result->setProperty("ns_per_block", nsPerBlock);
+    result->setProperty("block_size", blockSize);
+    result->setProperty("sample_rate", SR);
+}
+
+// everything benchmarked, with enough about the machine to tell runs apart
+static bool writeJson(const juce::File& file)
+{
+    auto* root = new juce::DynamicObject();
+    root->setProperty("benchmark", "drone_bench");
+    root->setProperty("time", juce::Time::getCurrentTime().toISO8601(true));
+    root->setProperty("cpu", juce::SystemStats::getCpuModel());
+    root->setProperty("os", juce::SystemStats::getOperatingSystemName());
+    root->setProperty("results", benchResults);
+
+    return file.replaceWithText(juce::JSON::toString(juce::var(root)));
+}
+
+//==============================================================================
+// ---- FILTER MODULATION ---- //
+
+// original processBlock behaviour, rebuilds IIRCoefficients every sample
+static double benchFilterPerSample()
+{
+    juce::IIRFilter filter;
+    juce::Random random(1);
+    FilterLFO lfo;
+    std::vector<float> block(benchBlock);
+
+    auto start = juce::Time::getHighResolutionTicks();
+
+    for (int b = 0; b < benchBlocks; b++)
+    {
+        for (auto& s : block)
+            s = random.nextFloat() * 2.0f - 1.0f;
+
+        for (int i = 0; i < benchBlock; i++)
+        {
+            int n = b * benchBlock + i;
+            filter.setCoefficients(juce::IIRCoefficients::makeLowPass(benchSR, lfo.cutoff(n), lfo.resonance(n)));
+            block[i] = filter.processSingleSampleRaw(block[i]);
+        }
+
+        benchSink = benchSink + block[0];
+    }
+
+    return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+}
+
+// ModFilter, coefficients only recomputed every controlRate samples
+static double benchModFilter(int controlRate)
+{
+    ModFilter filter;
+    juce::Random random(1);
+    FilterLFO lfo;
+    std::vector<float> block(benchBlock);
+
+    filter.prepare(benchSR, controlRate);
+
+    auto start = juce::Time::getHighResolutionTicks();
+
+    for (int b = 0; b < benchBlocks; b++)
+    {
+        for (auto& s : block)
+            s = random.nextFloat() * 2.0f - 1.0f;
+
+        for (int i = 0; i < benchBlock; i++)
+        {
+            int n = b * benchBlock + i;
+            filter.setTarget(lfo.cutoff(n), lfo.resonance(n));
+            block[i] = filter.processSample(block[i]);
+        }
+
+        benchSink = benchSink + block[0];
+    }
+
+    return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+}
+
+//==============================================================================
+// ---- SINE ENGINES ---- //
+
+static const int sineSamples = 10000000; // samples timed per sine engine
+
+// ns per sample for one sine engine, LFO style phase ramp at 441 Hz
+template <typename SineFunction>
+static double benchSine(SineFunction&& sine)
+{
+    float phase = 0.0f;
+    float delta = 441.0f / (float)benchSR;
+    float sum = 0.0f;
+
+    auto start = juce::Time::getHighResolutionTicks();
+
+    for (int i = 0; i < sineSamples; i++)
+    {
+        phase += delta;
+        if (phase > 1.0f)
+            phase -= 1.0f;
+
+        sum += sine(phase);
+    }
+
+    benchSink = benchSink + sum;
+
+    return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start) * 1.0e9 / sineSamples;
+}
+
+// peak error against double precision sin(), in dB relative to full scale
+template <typename SineFunction>
+static double sineErrorDB(SineFunction&& sine)
+{
+    const int points = 1 << 20;
+    double maxError = 0.0;
+
+    for (int i = 0; i <= points; i++)
+    {
+        float phase = (float)i / points;
+        double exact = std::sin(juce::MathConstants<double>::twoPi * (double)phase);
+        maxError = juce::jmax(maxError, std::abs((double)sine(phase) - exact));
+    }
+
+    return 20.0 * std::log10(juce::jmax(maxError, 1.0e-12));
+}
+
+template <typename SineFunction>
+static void reportSine(const juce::String& name, SineFunction&& sine)
+{
+    double ns = benchSine(sine);
+    double error = sineErrorDB(sine);
+
+    std::cout << name.paddedRight(' ', 36)
+              << juce::String(ns, 2).paddedLeft(' ', 12) << " ns/sample"
+              << juce::String(error, 1).paddedLeft(' ', 10) << " dB peak error\n";
+
+    auto* result = record(name);
+    result->setProperty("ns_per_sample", ns);
+    result->setProperty("peak_error_db", error);
+}
+
+//==============================================================================
+// ---- OSCILLATOR WAVEFORMS ---- //
+
+// ns per sample for one Oscillator waveform, at a chase synth pitch so PolyBLEP corrections come round often
+template <typename WaveFunction>
+static double benchWaveform(bool bandLimited, SineMode mode, WaveFunction&& wave)
+{
+    Oscillator osc;
+    osc.setSampleRate((float)benchSR);
+    osc.setFreq(1234.5f);
+    osc.setPulseWidth(0.4f);
+    osc.setBandLimited(bandLimited);
+    osc.setSineMode(mode);
+
+    float sum = 0.0f;
+
+    auto start = juce::Time::getHighResolutionTicks();
+
+    for (int i = 0; i < sineSamples; i++)
+        sum += wave(osc);
+
+    benchSink = benchSink + sum;
+
+    return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start) * 1.0e9 / sineSamples;
+}
+
+template <typename WaveFunction>
+static void reportWaveform(const juce::String& name, bool bandLimited, SineMode mode, WaveFunction&& wave)
+{
+    double ns = benchWaveform(bandLimited, mode, wave);
+
+    std::cout << name.paddedRight(' ', 36) << juce::String(ns, 2).paddedLeft(' ', 12) << " ns/sample\n";
+    record(name)->setProperty("ns_per_sample", ns);
+}
+
+//==============================================================================
+// ---- FREQUENCY MODULATION NOISE ---- //
+
+static const int fmVoices = 11; // ThickSynth at its biggest
+
+// original ThickSynth partial loop, juce::Random and setFreq for every partial on every sample
+static double benchFMRandom()
+{
+    OscillatorBank bank;
+    bank.setCapacity(fmVoices);
+    bank.setSampleRate((float)benchSR);
+    juce::Random random(1);
+
+    auto start = juce::Time::getHighResolutionTicks();
+
+    for (int b = 0; b < benchBlocks; b++)
+    {
+        for (int i = 0; i < benchBlock; i++)
+        {
+            for (int j = 0; j < fmVoices; j++)
+                bank.setFreq(j, 45.0f * (j + 1.2f) * (random.nextFloat() + 1.1f));
+        }
+
+        benchSink = benchSink + bank.getFreq(0);
+    }
+
+    return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+}
+
+// ModNoise a control period at a time, phase deltas set straight from an array
+static double benchFMNoise(int controlRate)
+{
+    OscillatorBank bank;
+    bank.setCapacity(fmVoices);
+    bank.setSampleRate((float)benchSR);
+
+    ModNoise noise;
+    noise.prepare(benchSR, fmVoices, controlRate);
+
+    float baseDelta[fmVoices], deltas[fmVoices];
+    for (int j = 0; j < fmVoices; j++)
+        baseDelta[j] = 45.0f * (j + 1.2f) / (float)benchSR;
+
+    auto start = juce::Time::getHighResolutionTicks();
+
+    for (int b = 0; b < benchBlocks; b++)
+    {
+        for (int done = 0; done < benchBlock; done += controlRate)
+        {
+            const float* rows = noise.process(controlRate);
+
+            for (int i = 0; i < controlRate; i++)
+            {
+                const float* row = rows + i * noise.getNumLanes();
+
+                for (int j = 0; j < fmVoices; j++)
+                    deltas[j] = baseDelta[j] * (row[j] + 1.1f);
+
+                bank.setPhaseDeltas(deltas, fmVoices);
+            }
+        }
+
+        benchSink = benchSink + bank.getFreq(0);
+    }
+
+    return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+}
+
+//==============================================================================
+// ---- CHASE DISTORTION ---- //
+
+static const int distortionControlRate = 32; // ChasingSynth moves the threshold this often
+
+// two detuned band limited triangles at chase synth level, what the distortion sees
+static std::vector<float> chaseInput()
+{
+    std::vector<float> input(benchBlock);
+    Oscillator a, b;
+
+    for (auto* osc : { &a, &b })
+    {
+        osc->setSampleRate((float)benchSR);
+        osc->setBandLimited(true);
+    }
+
+    a.setFreq(1234.5f);
+    b.setFreq(1234.5f * 1.37f);
+
+    for (auto& s : input)
+        s = (a.triWave() + b.triWave()) * 0.45f;
+
+    return input;
+}
+
+// threshold for control period n, swings through the whole LFO range like ChasingSynth's mod
+static float distortionThreshold(int n)
+{
+    return std::sin(n * 0.01f);
+}
+
+// original path, tanhf and the clipper one sample at a time
+static double benchDistortionPerSample()
+{
+    Effects effect;
+    auto input = chaseInput();
+    std::vector<float> block(benchBlock);
+
+    auto start = juce::Time::getHighResolutionTicks();
+
+    for (int b = 0; b < benchBlocks; b++)
+    {
+        for (int i = 0; i < benchBlock; i++)
+        {
+            if (i % distortionControlRate == 0)
+                effect.adjustDistortion(distortionThreshold(b * benchBlock + i));
+
+            block[i] = effect.tanDistortion(input[i]);
+        }
+
+        benchSink = benchSink + block[0];
+    }
+
+    return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+}
+
+// processBlock one control period at a time, as ChasingSynth calls it
+// 2x and 4x go through Effects' own juce::dsp::Oversampling (polyphase IIR), so they time exactly what ships
+static double benchDistortionBlock(int oversampling)
+{
+    Effects effect;
+    effect.setOversampling(oversampling);
+    effect.prepare(benchSR, distortionControlRate);
+
+    auto input = chaseInput();
+    std::vector<float> block(benchBlock);
+
+    auto start = juce::Time::getHighResolutionTicks();
+
+    for (int b = 0; b < benchBlocks; b++)
+    {
+        std::copy(input.begin(), input.end(), block.begin());
+
+        for (int i = 0; i < benchBlock; i += distortionControlRate)
+        {
+            effect.adjustDistortion(distortionThreshold(b * benchBlock + i));
+            effect.processBlock(block.data() + i, distortionControlRate);
+        }
+
+        benchSink = benchSink + block[0];
+    }
+
+    return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+}
+
+//==============================================================================
+// ---- CATCH DELAY ---- //
+
+// CatchDelay at a given delay time, a catch every couple of seconds keeps the time gliding
+// ring buffer is sized for the delay like the plugin sizes it for its longest echo
+static double benchCatchDelay(float delaySeconds)
+{
+    CatchDelay delay;
+    delay.setBaseDelay(delaySeconds);
+    delay.prepare(benchSR, delaySeconds * 1.5);
+
+    auto input = chaseInput();
+    std::vector<float> left(benchBlock), right(benchBlock);
+    int blocksPerCatch = (int)(2.0 * benchSR / benchBlock);
+
+    auto start = juce::Time::getHighResolutionTicks();
+
+    for (int b = 0; b < benchBlocks; b++)
+    {
+        if (b % blocksPerCatch == 0)
+            delay.catchTarget(b % (2 * blocksPerCatch) == 0 ? 650.0f : 750.0f, benchBlock / 2);
+
+        delay.process(input.data(), left.data(), right.data(), benchBlock);
+
+        benchSink = benchSink + left[0] + right[0];
+    }
+
+    return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+}
+
+//==============================================================================
+// ---- SYNTHS ---- //
+
+// ThickSynth renderBlock with the vector held at oscCount partials (no size or gain changes during the run)
+static double benchThickSynth(int oscCount)
+{
+    ThickSynth ts;
+    ts.setSeed(1);
+    ts.setNoiseSeed(2);
+    ts.prepare(benchSR, 32); // starts the piece from the seeds
+
+    auto state = ts.getState();
+    state.setProperty("oscCount", oscCount, nullptr);
+    state.setProperty("gainChangeIn", std::numeric_limits<juce::int64>::max() / 2, nullptr);
+    state.setProperty("sizeChangeIn", std::numeric_limits<juce::int64>::max() / 2, nullptr);
+    ts.setState(state);
+
+    std::vector<float> out(benchBlock), cutoffs(benchBlock), resonances(benchBlock);
+
+    auto start = juce::Time::getHighResolutionTicks();
+
+    for (int b = 0; b < benchBlocks; b++)
+    {
+        ts.renderBlock(out.data(), cutoffs.data(), resonances.data(), benchBlock);
+        benchSink = benchSink + out[0];
+    }
+
+    return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+}
+
+// ChasingSynth renderBlock chasing a ThickSynth style cutoff, catches and all
+static double benchChasingSynth()
+{
+    ChasingSynth cs;
+    cs.setSeed(3);
+    cs.prepare(benchSR, 32);
+
+    FilterLFO lfo;
+    std::vector<float> out(benchBlock), pans(benchBlock), cutoffs(benchBlock);
+    double seconds = 0.0;
+
+    for (int b = 0; b < benchBlocks; b++)
+    {
+        for (int i = 0; i < benchBlock; i++)
+            cutoffs[(size_t)i] = lfo.cutoff(b * benchBlock + i);
+
+        auto start = juce::Time::getHighResolutionTicks();
+        cs.renderBlock(out.data(), pans.data(), cutoffs.data(), benchBlock);
+        seconds += juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+
+        benchSink = benchSink + out[0];
+    }
+
+    return seconds;
+}
+
+// ChaseSwarm renderBlock with numChasers chasers, same cutoffs as benchChasingSynth, partials of a 45 Hz drone
+static double benchChaseSwarm(int numChasers)
+{
+    ChaseSwarm swarm;
+    swarm.setSeed(3);
+    swarm.prepare(benchSR, 32, numChasers);
+    swarm.reset();
+
+    FilterLFO lfo;
+    juce::AudioBuffer<float> lanes (ChaseSwarm::numLanes, benchBlock);
+    std::vector<float> cutoffs(benchBlock);
+    double seconds = 0.0;
+
+    for (int b = 0; b < benchBlocks; b++)
+    {
+        for (int i = 0; i < benchBlock; i++)
+            cutoffs[(size_t)i] = lfo.cutoff(b * benchBlock + i);
+
+        auto start = juce::Time::getHighResolutionTicks();
+        swarm.renderBlock(lanes.getArrayOfWritePointers(), cutoffs.data(), 45.0f, benchBlock);
+        seconds += juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+
+        benchSink = benchSink + lanes.getSample(0, 0);
+    }
+
+    return seconds;
+}
+
+//==============================================================================
+// ---- WHOLE PROCESSOR ---- //
+
+static const double processorSeconds = 20.0; // audio rendered per block size and sample rate
+
+// Drone_pieceAudioProcessor::processBlock, stereo, default parameters, processorSeconds of audio
+// returns seconds spent in processBlock, numBlocks is how many calls that was
+static double benchProcessBlock(double SR, int blockSize, int& numBlocks, int chasers = 1)
+{
+    Drone_pieceAudioProcessor drone;
+    drone.setSeed(1);
+    drone.setChasers(chasers);
+    drone.setRateAndBufferSizeDetails(SR, blockSize);
+    drone.prepareToPlay(SR, blockSize);
+
+    juce::AudioBuffer<float> buffer (juce::jmax(2, drone.getTotalNumOutputChannels()), blockSize);
+    juce::MidiBuffer midi;
+    numBlocks = (int)std::ceil(processorSeconds * SR / blockSize);
+
+    auto start = juce::Time::getHighResolutionTicks();
+
+    for (int b = 0; b < numBlocks; b++)
+    {
+        drone.processBlock(buffer, midi);
+        benchSink = benchSink + buffer.getSample(0, 0);
+    }
+
+    return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+}
+
+//==============================================================================
+// ---- TELEMETRY ---- //
+
+static const int editorFrameRate = 30; // how often the editor drains the telemetry
+
+// an open editor may cost processBlock this much, relative to closed plus a little for timer noise
+// drone_bench exits 1 past either
+static const double telemetryMeanRatio = 1.05, telemetryMeanSlackUs = 1.0;
+static const double telemetryP99Ratio = 1.25, telemetryP99SlackUs = 5.0;
+
+// processBlock with the editor closed (telemetry off) or open (on, drained at the editor's frame rate from another thread)
+// per block times come from the processor's own StageProfiler, so the tail (p99, max) shows any jitter, not just the mean
+static StageProfiler::Stats benchTelemetry(bool editorOpen)
+{
+    Drone_pieceAudioProcessor drone;
+    drone.setSeed(1);
+    drone.setRateAndBufferSizeDetails(benchSR, benchBlock);
+    drone.prepareToPlay(benchSR, benchBlock);
+
+    auto& telemetry = drone.getTelemetry();
+    telemetry.setActive(editorOpen);
+
+    std::atomic<bool> finished { false };
+    std::thread editor;
+
+    if (editorOpen)
+    {
+        editor = std::thread([&]
+        {
+            std::vector<float> samples (Telemetry::sampleCapacity);
+            Telemetry::State state;
+
+            while (! finished.load())
+            {
+                telemetry.readSamples(samples.data(), (int)samples.size());
+                telemetry.readState(state);
+                juce::Thread::sleep(1000 / editorFrameRate);
+            }
+        });
+    }
+
+    juce::AudioBuffer<float> buffer (juce::jmax(2, drone.getTotalNumOutputChannels()), benchBlock);
+    juce::MidiBuffer midi;
+
+    for (int b = 0; b < benchBlocks; b++)
+    {
+        drone.processBlock(buffer, midi);
+        benchSink = benchSink + buffer.getSample(0, 0);
+    }
+
+    finished = true;
+
+    if (editor.joinable())
+        editor.join();
+
+    telemetry.setActive(false);
+    return drone.getStageStats(StageProfiler::blockStage);
+}
+
+static StageProfiler::Stats reportTelemetry(const juce::String& name, bool editorOpen)
+{
+    auto stats = benchTelemetry(editorOpen);
+
+    std::cout << name.paddedRight(' ', 36)
+              << juce::String(stats.mean, 2).paddedLeft(' ', 10) << " us mean"
+              << juce::String(stats.p99, 2).paddedLeft(' ', 10) << " us p99"
+              << juce::String(stats.max, 2).paddedLeft(' ', 10) << " us max\n";
+
+    auto* result = record(name);
+    result->setProperty("us_mean", stats.mean);
+    result->setProperty("us_p99", stats.p99);
+    result->setProperty("us_max", stats.max);
+    result->setProperty("block_size", benchBlock);
+    result->setProperty("sample_rate", benchSR);
+    return stats;
+}
+
+// editor open against closed, false (and FAIL printed) if telemetry costs more than the bounds above
+static bool checkTelemetry(const StageProfiler::Stats& closed, const StageProfiler::Stats& open)
+{
+    double maxMean = closed.mean * telemetryMeanRatio + telemetryMeanSlackUs;
+    double maxP99 = closed.p99 * telemetryP99Ratio + telemetryP99SlackUs;
+    bool pass = open.mean <= maxMean && open.p99 <= maxP99;
+
+    std::cout << (pass ? "ok    " : "FAIL  ") << "editor open within " << juce::String(maxMean, 2) << " us mean and " << juce::String(maxP99, 2) << " us p99\n";
+
+    auto* result = record("editor open vs closed");
+    result->setProperty("pass", pass);
+    result->setProperty("us_mean_limit", maxMean);
+    result->setProperty("us_p99_limit", maxP99);
+    return pass;
+}
+
+//==============================================================================
+// ---- REPEATED PREPARE ---- //
+
+static const int preparePasses = 1000; // prepare calls, alternating sample rates
+
+// both synths prepared again and again between blocks, like a host switching sample rates and block sizes
+// once the voices exist nothing gets reallocated, a pass is just rescaling increments
+// seconds spent in prepare() only
+static double benchRepeatedPrepare()
+{
+    ThickSynth ts;
+    ChasingSynth cs;
+    ts.prepare(benchSR, 32);
+    cs.prepare(benchSR, 32);
+
+    std::vector<float> out(benchBlock), cutoffs(benchBlock), resonances(benchBlock), chase(benchBlock), pans(benchBlock);
+    double seconds = 0.0;
+
+    for (int p = 0; p < preparePasses; p++)
+    {
+        double SR = p % 2 == 0 ? 44100.0 : 96000.0;
+
+        auto start = juce::Time::getHighResolutionTicks();
+        ts.prepare(SR, 32);
+        cs.prepare(SR, 32);
+        seconds += juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+
+        ts.renderBlock(out.data(), cutoffs.data(), resonances.data(), benchBlock);
+        cs.renderBlock(chase.data(), pans.data(), cutoffs.data(), benchBlock);
+
+        benchSink = benchSink + out[0] + chase[0];
+    }
+
+    return seconds;
+}
+
+//==============================================================================
+// ---- REVERB ---- //
+
+// the plugin's reverb settings
+static juce::Reverb::Parameters benchReverbParameters()
+{
+    juce::Reverb::Parameters parameters;
+    parameters.dryLevel = 0.5f;
+    parameters.wetLevel = 0.3f;
+    parameters.roomSize = 0.7f;
+    return parameters;
+}
+
+// stereo reverb over noise, Reverb is juce::Reverb or FdnReverb
+template <typename Reverb>
+static double benchReverb(Reverb& reverb)
+{
+    juce::Random random(1);
+    std::vector<float> left(benchBlock), right(benchBlock);
+
+    auto start = juce::Time::getHighResolutionTicks();
+
+    for (int b = 0; b < benchBlocks; b++)
+    {
+        for (int i = 0; i < benchBlock; i++)
+        {
+            left[i] = random.nextFloat() * 0.2f - 0.1f;
+            right[i] = random.nextFloat() * 0.2f - 0.1f;
+        }
+
+        reverb.processStereo(left.data(), right.data(), benchBlock);
+
+        benchSink = benchSink + left[0] + right[0];
+    }
+
+    return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+}
+
+//==============================================================================
+// ---- ALIASING ---- //
+
+static const int aliasFFTOrder = 16; // 65536 point FFT
+
+// alias energy relative to total energy in dB, for one oscillator shape at frequency freq
+// anything that isn't within a few bins of a harmonic of freq counts as aliasing
+template <typename WaveFunction>
+static double aliasDB(float freq, bool bandLimited, WaveFunction&& wave)
+{
+    juce::dsp::FFT fft(aliasFFTOrder);
+    const int size = fft.getSize();
+    std::vector<float> data((size_t)size * 2, 0.0f);
+
+    Oscillator osc;
+    osc.setSampleRate((float)benchSR);
+    osc.setFreq(freq);
+    osc.setPulseWidth(0.4f);
+    osc.setBandLimited(bandLimited);
+
+    // Blackman-Harris window keeps leakage under the aliasing being measured
+    for (int i = 0; i < size; i++)
+    {
+        double w = juce::MathConstants<double>::twoPi * i / size;
+        double window = 0.35875 - 0.48829 * std::cos(w) + 0.14128 * std::cos(2.0 * w) - 0.01168 * std::cos(3.0 * w);
+        data[(size_t)i] = wave(osc) * (float)window;
+    }
+
+    fft.performFrequencyOnlyForwardTransform(data.data());
+
+    double binHz = benchSR / size;
+    double total = 0.0, alias = 0.0;
+
+    for (int bin = 12; bin < size / 2; bin++) // skip DC and window leakage around it
+    {
+        double power = (double)data[(size_t)bin] * data[(size_t)bin];
+        double harmonic = std::round(bin * binHz / freq);
+        bool isHarmonic = harmonic >= 1.0 && std::abs(bin * binHz - harmonic * freq) < 6.0 * binHz;
+
+        total += power;
+        if (! isHarmonic)
+            alias += power;
+    }
+
+    return 10.0 * std::log10(juce::jmax(alias, 1.0e-30) / juce::jmax(total, 1.0e-30));
+}
+
+// aliasing of the chase distortion on one band limited triangle, threshold held where the clipper bites
+// oversampling 0 = original per sample tanDistortion
+static void reportDistortionAlias(const juce::String& name, float freq, int oversampling)
+{
+    Effects effect;
+    effect.setOversampling(oversampling);
+    effect.prepare(benchSR, 1);
+    effect.adjustDistortion(0.5f);
+
+    auto distort = [&] (Oscillator& osc)
+    {
+        float sample = osc.triWave() * 0.45f;
+
+        if (oversampling == 0)
+            return effect.tanDistortion(sample);
+
+        effect.processBlock(&sample, 1);
+        return sample;
+    };
+
+    std::cout << (name + " " + juce::String(freq, 1) + " Hz").paddedRight(' ', 36)
+              << juce::String(aliasDB(freq, true, distort), 1).paddedLeft(' ', 12) << " dB\n";
+}
+
+static void reportAlias(const juce::String& name, float freq, bool bandLimited)
+{
+    auto square = [] (Oscillator& osc) { return osc.squareWave(); };
+    auto tri = [] (Oscillator& osc) { return osc.triWave(); };
+
+    double squareDB = aliasDB(freq, bandLimited, square);
+    double triDB = aliasDB(freq, bandLimited, tri);
+
+    std::cout << (name + " " + juce::String(freq, 1) + " Hz").paddedRight(' ', 36)
+              << juce::String(squareDB, 1).paddedLeft(' ', 12) << " dB square"
+              << juce::String(triDB, 1).paddedLeft(' ', 10) << " dB triangle\n";
+
+    auto* result = record(name + " " + juce::String(freq, 1) + " Hz");
+    result->setProperty("square_alias_db", squareDB);
+    result->setProperty("triangle_alias_db", triDB);
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInit; // the processor expects a message manager to exist
+
+    juce::ArgumentList args (argc, argv);
+
+    std::cout << "drone_bench: " << benchBlocks << " blocks of " << benchBlock
+              << " samples at " << benchSR << " Hz\n";
+
+    section("filter modulation");
+
+    // note: both runs include the same LFO and noise generation, so the difference is the filter
+    report("IIRFilter + makeLowPass per sample", benchFilterPerSample());
+
+    for (int rate : { 1, 16, 32, 64 })
+        report("ModFilter control rate " + juce::String(rate), benchModFilter(rate));
+
+    section("frequency modulation, " + juce::String(fmVoices) + " partials");
+
+    report("juce::Random + setFreq per partial", benchFMRandom());
+    report("ModNoise + setPhaseDeltas", benchFMNoise(32));
+
+    section("sine engines, " + juce::String(sineSamples) + " samples each");
+
+    reportSine("std::sin (double)", [] (float ph) { return (float)std::sin(juce::MathConstants<double>::twoPi * ph); });
+    reportSine("sinf", [] (float ph) { return sinf(ph * TP); });
+    reportSine("FastSine::tableLinear", [] (float ph) { return FastSine::tableLinear(ph); });
+    reportSine("FastSine::tableCubic", [] (float ph) { return FastSine::tableCubic(ph); });
+    reportSine("FastSine::poly5", [] (float ph) { return FastSine::poly5(ph); });
+    reportSine("FastSine::poly7", [] (float ph) { return FastSine::poly7(ph); });
+
+    section("Oscillator waveforms, 1234.5 Hz, " + juce::String(sineSamples) + " samples each");
+
+    reportWaveform("process (phasor)", false, SineMode::precise, [] (Oscillator& o) { return o.process(); });
+    reportWaveform("sineWave precise", false, SineMode::precise, [] (Oscillator& o) { return o.sineWave(); });
+    reportWaveform("sineWave poly7", false, SineMode::poly7, [] (Oscillator& o) { return o.sineWave(); });
+    reportWaveform("squareWave naive", false, SineMode::precise, [] (Oscillator& o) { return o.squareWave(); });
+    reportWaveform("squareWave PolyBLEP", true, SineMode::precise, [] (Oscillator& o) { return o.squareWave(); });
+    reportWaveform("triWave naive", false, SineMode::precise, [] (Oscillator& o) { return o.triWave(); });
+    reportWaveform("triWave PolyBLEP", true, SineMode::precise, [] (Oscillator& o) { return o.triWave(); });
+
+    std::cout << "\naliasing, energy away from the harmonics relative to total\n";
+
+    // frequencies chosen so they don't divide the sample rate, otherwise aliases land on harmonics
+    for (float freq : { 1234.5f, 3217.3f, 5123.7f, 8111.1f })
+    {
+        reportAlias("naive", freq, false);
+        reportAlias("PolyBLEP", freq, true);
+    }
+
+    section("chase distortion, threshold moving every " + juce::String(distortionControlRate) + " samples");
+
+    report("tanhf + clip per sample", benchDistortionPerSample());
+    report("processBlock 1x, ADAA", benchDistortionBlock(1));
+    report("processBlock 2x, dsp::Oversampling", benchDistortionBlock(2));
+    report("processBlock 4x, dsp::Oversampling", benchDistortionBlock(4));
+
+    section("catch delay, stereo ping pong, gliding delay time");
+
+    for (float seconds : { 0.25f, 2.0f, 10.0f, 30.0f })
+        report("CatchDelay " + juce::String(seconds, 2) + " s", benchCatchDelay(seconds));
+
+    section("synths, renderBlock");
+
+    for (int oscCount = 3; oscCount <= 11; oscCount++)
+        report("ThickSynth " + juce::String(oscCount) + " partials", benchThickSynth(oscCount));
+
+    report("ChasingSynth", benchChasingSynth());
+
+    section("chase swarm, renderBlock (ChasingSynth above is one chaser)");
+
+    // cost per chaser should fall as the SIMD registers fill up and the lanes are shared
+    for (int chasers : { 1, 2, 4, 8, 16, 32, 64, 128, 256 })
+        report("ChaseSwarm " + juce::String(chasers) + " chasers", benchChaseSwarm(chasers));
+
+    section("repeated prepare, " + juce::String(preparePasses) + " passes alternating 44.1 / 96 kHz, a block rendered between each");
+
+    double prepareMicroseconds = benchRepeatedPrepare() * 1.0e6 / preparePasses;
+    std::cout << juce::String("ThickSynth + ChasingSynth prepare").paddedRight(' ', 36)
+              << juce::String(prepareMicroseconds, 2).paddedLeft(' ', 12) << " us/pass\n";
+    record("ThickSynth + ChasingSynth prepare")->setProperty("us_per_pass", prepareMicroseconds);
+
+    section("reverb, stereo, plugin settings (noise generation included)");
+
+    juce::Reverb freeverb;
+    freeverb.setParameters(benchReverbParameters());
+    freeverb.setSampleRate(benchSR);
+    report("juce::Reverb", benchReverb(freeverb));
+
+    for (int lines : { 4, 8, 16 })
+    {
+        FdnReverb fdn;
+        fdn.setNumLines(lines);
+        fdn.setParameters(benchReverbParameters());
+        fdn.setSampleRate(benchSR);
+        report("FdnReverb " + juce::String(lines) + " lines", benchReverb(fdn));
+    }
+
+    section("whole processBlock, stereo, " + juce::String(processorSeconds, 0) + " s of audio per run");
+
+    for (double SR : { 44100.0, 96000.0, 192000.0 })
+    {
+        for (int blockSize : { 16, 64, 256, 1024, 4096 })
+        {
+            int numBlocks = 0;
+            double seconds = benchProcessBlock(SR, blockSize, numBlocks);
+            report("processBlock " + juce::String(SR / 1000.0, 1) + " kHz, " + juce::String(blockSize), seconds, blockSize, numBlocks, SR);
+        }
+    }
+
+    section("whole processBlock with a chase swarm, stereo, 48 kHz, " + juce::String(benchBlock));
+
+    for (int chasers : { 2, 16, 64, 256 })
+    {
+        int numBlocks = 0;
+        double seconds = benchProcessBlock(benchSR, benchBlock, numBlocks, chasers);
+        report("processBlock " + juce::String(chasers) + " chasers", seconds, benchBlock, numBlocks);
+    }
+
+    section("telemetry, processBlock per block, " + juce::String(benchBlocks) + " blocks of " + juce::String(benchBlock));
+
+    bool passed = true;
+
+    if (StageProfiler::isEnabled())
+    {
+        auto closed = reportTelemetry("editor closed (telemetry off)", false);
+        auto open = reportTelemetry("editor open (drained at " + juce::String(editorFrameRate) + " Hz)", true);
+        passed = checkTelemetry(closed, open);
+    }
+    else
+        std::cout << "needs the profiler, built with DRONE_PROFILING=0\n";
+
+    std::cout << "\nchase distortion aliasing, threshold 0.5\n";
+
+    for (float freq : { 1234.5f, 3217.3f })
+    {
+        reportDistortionAlias("tanhf + clip per sample", freq, 0);
+        reportDistortionAlias("processBlock 1x", freq, 1);
+        reportDistortionAlias("processBlock 2x", freq, 2);
+        reportDistortionAlias("processBlock 4x", freq, 4);
+    }
+
+    if (args.containsOption("--json"))
+    {
+        auto file = juce::File::getCurrentWorkingDirectory().getChildFile(args.getValueForOption("--json"));
+
+        if (! writeJson(file))
+        {
+            std::cerr << "couldn't write " << file.getFullPathName() << "\n";
+            return 1;
+        }
+
+        std::cout << "\n" << benchResults.size() << " results written to " << file.getFullPathName() << "\n";
+    }
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,906 @@
+/*
+  ==============================================================================
+
+    Golden render regression check for the drone.
+    Renders fixed seed segments of Drone_pieceAudioProcessor and compares them with reference renders
+    recorded earlier, so an optimisation that changes the sound gets caught before it ships.
+    Every segment is checked at block sizes from 1 to 4096 (and a run of random ones),
+    against a reference rendered at referenceBlock, so block boundary bugs show up too.
+    --check also holds the DSP building blocks to the accuracy their docs promise (see ENGINE CHECKS).
+    Headless, no audio device, exits 0 if everything passes, 1 if anything fails, 2 for bad arguments.
+
+    usage: drone_golden --record [dir]
+           drone_golden --check [dir] [--mode exact|tolerance] [--max-error -60] [--max-spectral 1]
+                                      [--blocks 1,64,4096,random] [--case name] [--require-references]
+    Cases with no reference recorded are checked at every block size against their own referenceBlock render,
+    which catches block boundary bugs but not changes to the sound, until references are recorded.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../Source/PluginProcessor.h"
+#include "../Source/allocationCounter.h"
+
+//==============================================================================
+// ---- CASES ---- //
+
+// one fixed segment of the piece
+struct GoldenCase
+{
+    const char* name; // reference file is <name>.wav
+    juce::int64 seed;
+    double sampleRate;
+    double startSeconds; // seeked to first, 0 = from the top
+    double lengthSeconds;
+    int reverbLines; // 0 = juce::Reverb, 4 / 8 / 16 = FdnReverb
+    int oversample; // chase synth distortion oversampling
+    int chasers; // 1 = chase synth, more = ChaseSwarm
+};
+
+static const GoldenCase goldenCases[] =
+{
+    { "seed1_48k",          1, 48000.0,   0.0, 5.0, 0, 1, 1 },
+    { "seed2_44k1_fdn8",    2, 44100.0,   0.0, 5.0, 8, 1, 1 },
+    { "seed3_48k_seek600",  3, 48000.0, 600.0, 5.0, 0, 1, 1 },
+    { "seed4_96k_os2",      4, 96000.0,   0.0, 3.0, 4, 2, 1 },
+    { "seed5_48k_swarm16",  5, 48000.0,  60.0, 5.0, 8, 1, 16 },
+};
+
+static const int referenceBlock = 512; // block size references are recorded at
+static const int maxBlock = 4096; // biggest block checked, and what random runs are prepared for
+static const int randomBlocks = -1; // stands for "random sizes 1 - maxBlock" in a block list
+
+// odd sizes and sizes either side of the control rate (32) on purpose, that's where boundary bugs live
+static const int defaultBlocks[] = { 1, 2, 3, 7, 31, 32, 33, 64, 127, 441, 512, 1000, 1024, 2048, 4096, randomBlocks };
+
+static juce::String blockName(int blockSize)
+{
+    return blockSize == randomBlocks ? juce::String("random") : juce::String(blockSize);
+}
+
+//==============================================================================
+// ---- RENDER ---- //
+
+// a drone set up for a case, prepared the way a host would for blocks of up to preparedBlock
+static void prepareCase(Drone_pieceAudioProcessor& drone, const GoldenCase& c, int preparedBlock)
+{
+    drone.setSeed(c.seed);
+    drone.setReverbEngine(c.reverbLines);
+    drone.setDistortionOversampling(c.oversample);
+    drone.setChasers(c.chasers);
+    drone.setRateAndBufferSizeDetails(c.sampleRate, preparedBlock);
+    drone.prepareToPlay(c.sampleRate, preparedBlock);
+}
+
+// renders a case into out (sized here), blockSize samples per processBlock, or random sizes for randomBlocks
+// prepared for blockSize, or maxBlock when sizes vary
+static void renderCase(const GoldenCase& c, int blockSize, juce::AudioBuffer<float>& out)
+{
+    Drone_pieceAudioProcessor drone;
+    int preparedBlock = blockSize == randomBlocks ? maxBlock : blockSize;
+    prepareCase(drone, c, preparedBlock);
+
+    if (c.startSeconds > 0.0)
+        drone.seekTo(c.startSeconds);
+
+    int numChannels = juce::jmax(2, drone.getTotalNumOutputChannels());
+    int totalSamples = (int)std::llround(c.lengthSeconds * c.sampleRate);
+    out.setSize(numChannels, totalSamples);
+
+    juce::AudioBuffer<float> buffer (numChannels, preparedBlock);
+    juce::MidiBuffer midi;
+    juce::Random sizes (c.seed); // same "random" host every run
+
+    for (int done = 0; done < totalSamples;)
+    {
+        int numSamples = blockSize == randomBlocks ? sizes.nextInt(maxBlock) + 1 : blockSize;
+        numSamples = juce::jmin(numSamples, totalSamples - done);
+        buffer.setSize(numChannels, numSamples, false, false, true);
+
+        drone.processBlock(buffer, midi);
+
+        for (int ch = 0; ch < numChannels; ch++)
+            out.copyFrom(ch, done, buffer, ch, 0, numSamples);
+
+        done += numSamples;
+    }
+}
+
+//==============================================================================
+// ---- REFERENCE FILES ---- //
+
+// 32 bit float WAV, samples go in and come back out bit for bit (and the references can be listened to)
+static bool writeReference(const juce::File& file, const juce::AudioBuffer<float>& audio, double sampleRate)
+{
+    file.deleteFile();
+    auto stream = file.createOutputStream();
+
+    if (stream == nullptr)
+        return false;
+
+    juce::WavAudioFormat wav;
+    std::unique_ptr<juce::AudioFormatWriter> writer (wav.createWriterFor(stream.get(), sampleRate,
+                                                                        (unsigned int)audio.getNumChannels(), 32, {}, 0));
+
+    if (writer == nullptr)
+        return false;
+
+    stream.release(); // writer owns the stream now
+    return writer->writeFromAudioSampleBuffer(audio, 0, audio.getNumSamples());
+}
+
+static bool readReference(const juce::File& file, juce::AudioBuffer<float>& audio, double& sampleRate)
+{
+    juce::WavAudioFormat wav;
+    std::unique_ptr<juce::AudioFormatReader> reader (wav.createReaderFor(file.createInputStream().release(), true));
+
+    if (reader == nullptr)
+        return false;
+
+    sampleRate = reader->sampleRate;
+    audio.setSize((int)reader->numChannels, (int)reader->lengthInSamples);
+    return reader->read(&audio, 0, (int)reader->lengthInSamples, 0, true, true);
+}
+
+//==============================================================================
+// ---- COMPARISON ---- //
+
+struct Comparison
+{
+    juce::int64 mismatches = 0; // samples (any channel) that aren't bit for bit the same
+    int firstMismatch = -1; // sample index, -1 = none
+    double errorDB = -std::numeric_limits<double>::infinity(); // difference energy relative to the reference
+    double peakErrorDB = -std::numeric_limits<double>::infinity(); // biggest single difference, dBFS
+    double spectralDB = 0.0; // log spectral distance, see spectralDistance
+};
+
+static const int spectralOrder = 12; // 4096 point frames, half overlapping
+static const float spectralFloor = 1.0e-5f; // -100 dBFS, quieter bins count as this so silence doesn't blow up the log
+
+// mean over frames of the RMS dB difference between the two spectra (mono mixes), 0 = same spectrum
+static double spectralDistance(const juce::AudioBuffer<float>& reference, const juce::AudioBuffer<float>& test)
+{
+    const int size = 1 << spectralOrder;
+    juce::dsp::FFT fft (spectralOrder);
+    juce::dsp::WindowingFunction<float> window ((size_t)size, juce::dsp::WindowingFunction<float>::hann);
+    std::vector<float> a ((size_t)size * 2), b ((size_t)size * 2);
+
+    // window's normalised to sum to size, so a full scale sine peaks at size / 2
+    float floorMagnitude = spectralFloor * size * 0.5f;
+    double total = 0.0;
+    int frames = 0;
+
+    for (int start = 0; start + size <= reference.getNumSamples(); start += size / 2)
+    {
+        std::fill(a.begin(), a.end(), 0.0f);
+        std::fill(b.begin(), b.end(), 0.0f);
+
+        for (int ch = 0; ch < reference.getNumChannels(); ch++)
+        {
+            juce::FloatVectorOperations::add(a.data(), reference.getReadPointer(ch, start), size);
+            juce::FloatVectorOperations::add(b.data(), test.getReadPointer(ch, start), size);
+        }
+
+        window.multiplyWithWindowingTable(a.data(), (size_t)size);
+        window.multiplyWithWindowingTable(b.data(), (size_t)size);
+        fft.performFrequencyOnlyForwardTransform(a.data());
+        fft.performFrequencyOnlyForwardTransform(b.data());
+
+        double sum = 0.0;
+
+        for (int bin = 1; bin < size / 2; bin++)
+        {
+            double dB = 20.0 * std::log10(juce::jmax(a[bin], floorMagnitude) / juce::jmax(b[bin], floorMagnitude));
+            sum += dB * dB;
+        }
+
+        total += std::sqrt(sum / (size / 2 - 1));
+        frames++;
+    }
+
+    return frames > 0 ? total / frames : 0.0;
+}
+
+static Comparison compare(const juce::AudioBuffer<float>& reference, const juce::AudioBuffer<float>& test)
+{
+    Comparison result;
+    double differenceEnergy = 0.0, referenceEnergy = 0.0, peak = 0.0;
+
+    for (int ch = 0; ch < reference.getNumChannels(); ch++)
+    {
+        auto* ref = reference.getReadPointer(ch);
+        auto* out = test.getReadPointer(ch);
+
+        for (int i = 0; i < reference.getNumSamples(); i++)
+        {
+            // bit for bit, so -0 vs 0 and differing NaN's count too
+            if (std::memcmp(ref + i, out + i, sizeof(float)) != 0)
+            {
+                result.mismatches++;
+
+                if (result.firstMismatch < 0 || i < result.firstMismatch)
+                    result.firstMismatch = i;
+            }
+
+            double difference = (double)out[i] - (double)ref[i];
+            differenceEnergy += difference * difference;
+            referenceEnergy += (double)ref[i] * ref[i];
+            peak = juce::jmax(peak, std::abs(difference));
+        }
+    }
+
+    if (differenceEnergy > 0.0)
+        result.errorDB = 10.0 * std::log10(differenceEnergy / juce::jmax(referenceEnergy, 1.0e-30));
+
+    if (peak > 0.0)
+        result.peakErrorDB = 20.0 * std::log10(peak);
+
+    if (result.mismatches > 0)
+        result.spectralDB = spectralDistance(reference, test);
+
+    return result;
+}
+
+static juce::String formatDB(double dB)
+{
+    return std::isinf(dB) ? juce::String("-inf") : juce::String(dB, 1);
+}
+
+//==============================================================================
+// ---- ENGINE CHECKS ---- //
+
+// the building blocks held to what their docs promise, no references needed
+// run by every --check after the renders
+
+// prints one engine check, true if it passed
+static bool engineResult(const juce::String& name, bool pass, const juce::String& detail)
+{
+    std::cout << name.paddedRight(' ', 44) << juce::String(pass ? "ok" : "FAIL").paddedLeft(' ', 6) << "  " << detail << "\n";
+    return pass;
+}
+
+static double toDB(double amplitude)
+{
+    return amplitude > 0.0 ? 20.0 * std::log10(amplitude) : -std::numeric_limits<double>::infinity();
+}
+
+static const double bankToleranceDB = -100.0; // OscillatorBank vs Oscillator, float rounding is around -127 dB
+
+// OscillatorBank against the Oscillators it replaced, every wave type, naive and band limited
+// a second at 48 kHz, voices spread from 55 Hz to nearly 5 kHz so PolyBLEP corrections come round often
+static int checkOscillatorBank()
+{
+    const int numVoices = 12;
+    const float SR = 48000.0f;
+    const char* waveNames[] = { "square", "sine", "triangle" };
+    int failures = 0;
+
+    for (bool bandLimited : { false, true })
+    {
+        OscillatorBank bank;
+        bank.setCapacity(numVoices);
+        bank.setSampleRate(SR);
+
+        std::vector<Oscillator> oscillators ((size_t)numVoices);
+
+        for (int i = 0; i < numVoices; i++)
+        {
+            float freq = 55.0f * std::pow(1.5f, (float)i);
+
+            oscillators[(size_t)i].setSampleRate(SR);
+            oscillators[(size_t)i].setFreq(freq);
+            oscillators[(size_t)i].setPulseWidth(0.4f);
+            oscillators[(size_t)i].setBandLimited(bandLimited);
+
+            bank.setFreq(i, freq);
+            bank.setPulseWidth(i, 0.4f);
+            bank.setBandLimited(i, bandLimited);
+            bank.setWaveType(i, (OscillatorBank::WaveType)(i % 3));
+            bank.activate(i, 0);
+        }
+
+        double maxDifference[3] = { 0.0, 0.0, 0.0 };
+
+        for (int s = 0; s < (int)SR; s++)
+        {
+            const float* out = bank.process(numVoices);
+
+            for (int i = 0; i < numVoices; i++)
+            {
+                auto& osc = oscillators[(size_t)i];
+                float expected = i % 3 == OscillatorBank::square ? osc.squareWave()
+                               : i % 3 == OscillatorBank::sine   ? osc.sineWave()
+                                                                 : osc.triWave();
+
+                maxDifference[i % 3] = juce::jmax(maxDifference[i % 3], (double)std::abs(out[i] - expected));
+            }
+        }
+
+        for (int wave = 0; wave < 3; wave++)
+        {
+            double dB = toDB(maxDifference[wave]);
+            bool pass = dB <= bankToleranceDB;
+
+            if (! engineResult("OscillatorBank " + juce::String(waveNames[wave]) + (bandLimited ? " band limited" : ""), pass,
+                               "peak difference from Oscillator " + formatDB(dB) + " dB, limit " + formatDB(bankToleranceDB)))
+                failures++;
+        }
+    }
+
+    return failures;
+}
+
+// FastSine modes and the peak error osc.h documents for each
+struct SineEngine
+{
+    SineMode mode;
+    const char* name;
+    double documentedDB; // peak error against double precision sin(), full scale
+};
+
+static const SineEngine sineEngines[] =
+{
+    { SineMode::tableLinear, "tableLinear", -118.0 },
+    { SineMode::tableCubic,  "tableCubic",  -133.0 },
+    { SineMode::poly5,       "poly5",        -83.0 },
+    { SineMode::poly7,       "poly7",       -116.0 },
+};
+
+static const double sineSlackDB = 1.0; // the figures are rounded, and compilers may fuse multiply adds
+
+// each FastSine mode against double precision sin() over 2^20 + 1 phases, the same sweep drone_bench reports
+static int checkSineEngines()
+{
+    const int points = 1 << 20;
+    int failures = 0;
+
+    for (const auto& engine : sineEngines)
+    {
+        double maxError = 0.0;
+
+        for (int i = 0; i <= points; i++)
+        {
+            float phase = (float)i / points;
+            double exact = std::sin(juce::MathConstants<double>::twoPi * (double)phase);
+            maxError = juce::jmax(maxError, std::abs((double)FastSine::sine(engine.mode, phase) - exact));
+        }
+
+        double dB = toDB(maxError);
+        bool pass = dB <= engine.documentedDB + sineSlackDB;
+
+        if (! engineResult("FastSine " + juce::String(engine.name), pass,
+                           "peak error " + formatDB(dB) + " dB, documented " + formatDB(engine.documentedDB)))
+            failures++;
+    }
+
+    return failures;
+}
+
+// PolyBLEP square and triangle aliasing at 48 kHz, the same measurement drone_bench reports:
+// Blackman-Harris windowed 65536 point FFT, energy away from the harmonics relative to the total
+struct AliasLimit
+{
+    float freq; // doesn't divide the sample rate, otherwise aliases land on harmonics
+    bool triangle; // or square, pulse width 0.4
+    double maxDB; // band limited aliasing no worse than this
+    double minImprovementDB; // and at least this much under the naive wave's
+};
+
+// limits sit 2 - 3 dB outside what the current PolyBLEP measures
+static const AliasLimit aliasLimits[] =
+{
+    { 1234.5f, false, -31.0, 14.0 },
+    { 1234.5f, true,  -57.0, 10.0 },
+    { 5123.7f, false, -27.0, 15.0 },
+    { 5123.7f, true,  -34.0,  8.0 },
+};
+
+static const int aliasFFTOrder = 16;
+
+static double aliasDB(float freq, bool triangle, bool bandLimited)
+{
+    const double SR = 48000.0;
+    juce::dsp::FFT fft (aliasFFTOrder);
+    const int size = fft.getSize();
+    std::vector<float> data ((size_t)size * 2, 0.0f);
+
+    Oscillator osc;
+    osc.setSampleRate((float)SR);
+    osc.setFreq(freq);
+    osc.setPulseWidth(0.4f);
+    osc.setBandLimited(bandLimited);
+
+    for (int i = 0; i < size; i++)
+    {
+        double w = juce::MathConstants<double>::twoPi * i / size;
+        double window = 0.35875 - 0.48829 * std::cos(w) + 0.14128 * std::cos(2.0 * w) - 0.01168 * std::cos(3.0 * w);
+        data[(size_t)i] = (triangle ? osc.triWave() : osc.squareWave()) * (float)window;
+    }
+
+    fft.performFrequencyOnlyForwardTransform(data.data());
+
+    double binHz = SR / size;
+    double total = 0.0, alias = 0.0;
+
+    for (int bin = 12; bin < size / 2; bin++) // skip DC and window leakage around it
+    {
+        double power = (double)data[(size_t)bin] * data[(size_t)bin];
+        double harmonic = std::round(bin * binHz / freq);
+        bool isHarmonic = harmonic >= 1.0 && std::abs(bin * binHz - harmonic * freq) < 6.0 * binHz;
+
+        total += power;
+        if (! isHarmonic)
+            alias += power;
+    }
+
+    return 10.0 * std::log10(juce::jmax(alias, 1.0e-30) / juce::jmax(total, 1.0e-30));
+}
+
+static int checkAliasing()
+{
+    int failures = 0;
+
+    for (const auto& limit : aliasLimits)
+    {
+        double bandLimitedDB = aliasDB(limit.freq, limit.triangle, true);
+        double improvementDB = aliasDB(limit.freq, limit.triangle, false) - bandLimitedDB;
+        bool pass = bandLimitedDB <= limit.maxDB && improvementDB >= limit.minImprovementDB;
+
+        if (! engineResult("PolyBLEP " + juce::String(limit.triangle ? "triangle " : "square ") + juce::String(limit.freq, 1) + " Hz", pass,
+                           "aliasing " + formatDB(bandLimitedDB) + " dB (limit " + formatDB(limit.maxDB) + "), "
+                           + formatDB(improvementDB) + " dB under naive (limit " + formatDB(limit.minImprovementDB) + ")"))
+            failures++;
+    }
+
+    return failures;
+}
+
+// seekTo against playing: one drone seeks to startSeconds, another renders all the way there, then both play lengthSeconds more
+// every partial change, random number, chase and event has to land in the same place (generative state compared,
+// floats within seekTolerance), phases are left out, oscillators and LFO's jump at their average frequency while seeking
+static const GoldenCase seekCase = { "seek", 3, 48000.0, 60.0, 5.0, 0, 1, 1 };
+static const double seekTolerance = 1.0e-4; // relative, for the float properties
+static const char* seekSkipped = "phase"; // any property with this in its name, in any case
+
+// numSamples more of a prepared drone, in referenceBlock blocks, output thrown away
+static void play(Drone_pieceAudioProcessor& drone, juce::int64 numSamples)
+{
+    juce::AudioBuffer<float> buffer (juce::jmax(2, drone.getTotalNumOutputChannels()), referenceBlock);
+    juce::MidiBuffer midi;
+
+    for (juce::int64 done = 0; done < numSamples;)
+    {
+        int numSamplesNow = (int)juce::jmin((juce::int64)referenceBlock, numSamples - done);
+        buffer.setSize(buffer.getNumChannels(), numSamplesNow, false, false, true);
+        drone.processBlock(buffer, midi);
+        done += numSamplesNow;
+    }
+}
+
+// the generative state (both synths) out of getStateInformation: magic, XML size, XML, snapshot
+static juce::ValueTree generativeState(Drone_pieceAudioProcessor& drone)
+{
+    juce::MemoryBlock data;
+    drone.getStateInformation(data);
+
+    if (data.getSize() < 8)
+        return {};
+
+    int xmlSize = (int)juce::ByteOrder::littleEndianInt((const char*)data.getData() + 4);
+    auto xml = juce::AudioProcessor::getXmlFromBinary((const char*)data.getData() + 8, xmlSize);
+
+    return xml != nullptr ? juce::ValueTree::fromXml(*xml).getChildWithName("generative") : juce::ValueTree();
+}
+
+// properties of a that b doesn't match, first one described in firstDifference
+static int stateDifferences(const juce::ValueTree& a, const juce::ValueTree& b, juce::String& firstDifference)
+{
+    auto note = [&] (const juce::String& what)
+    {
+        if (firstDifference.isEmpty())
+            firstDifference = what;
+
+        return 1;
+    };
+
+    if (! a.isValid() || a.getType() != b.getType() || a.getNumChildren() != b.getNumChildren())
+        return note(a.getType().toString() + " has a different shape");
+
+    int differences = 0;
+
+    for (int p = 0; p < a.getNumProperties(); p++)
+    {
+        auto name = a.getPropertyName(p);
+
+        if (name.toString().containsIgnoreCase(seekSkipped))
+            continue;
+
+        // out of XML every value is a string, whole numbers (seeds, counts, samples until events) have to match exactly
+        auto x = a[name].toString(), y = b[name].toString();
+        bool same = x == y;
+
+        if (! same && x.containsAnyOf(".e") && y.containsAnyOf(".e"))
+            same = std::abs(x.getDoubleValue() - y.getDoubleValue()) <= seekTolerance * juce::jmax(1.0, std::abs(x.getDoubleValue()));
+
+        if (! same)
+            differences += note(a.getType().toString() + "." + name.toString() + " " + x + " playing, " + y + " seeking");
+    }
+
+    for (int i = 0; i < a.getNumChildren(); i++)
+        differences += stateDifferences(a.getChild(i), b.getChild(i), firstDifference);
+
+    return differences;
+}
+
+static int checkSeeking()
+{
+    Drone_pieceAudioProcessor playing, seeking;
+
+    // offline, so getStateInformation reads the state straight out instead of waiting for an audio thread
+    for (auto* drone : { &playing, &seeking })
+    {
+        drone->setNonRealtime(true);
+        prepareCase(*drone, seekCase, referenceBlock);
+    }
+
+    auto compareStates = [&] (const juce::String& name)
+    {
+        juce::String firstDifference;
+        int differences = stateDifferences(generativeState(playing), generativeState(seeking), firstDifference);
+
+        return engineResult(name, differences == 0,
+                            differences == 0 ? "generative state matches playing, floats within " + juce::String(seekTolerance * 100.0, 2) + "%"
+                                             : juce::String(differences) + " differences, first " + firstDifference);
+    };
+
+    play(playing, (juce::int64)std::llround(seekCase.startSeconds * seekCase.sampleRate));
+    seeking.seekTo(seekCase.startSeconds);
+
+    int failures = compareStates("seekTo " + juce::String(seekCase.startSeconds, 0) + " s") ? 0 : 1;
+
+    auto after = (juce::int64)std::llround(seekCase.lengthSeconds * seekCase.sampleRate);
+    play(playing, after);
+    play(seeking, after);
+
+    failures += compareStates("seekTo, then " + juce::String(seekCase.lengthSeconds, 0) + " s played") ? 0 : 1;
+
+    return failures;
+}
+
+// ThickSynth and ChasingSynth prepared again and again at the same rate, the way hosts do on every transport start:
+// after the first one, more prepares must change nothing (output bit for bit) and allocate nothing
+static const int preparePasses = 100;
+
+// a block, prepare() 1 + extraPrepares times, another block, both blocks of both synths in out
+// returns the allocations the extra prepares made
+static int renderAroundPrepares(int extraPrepares, std::vector<float>& out)
+{
+    const double SR = 48000.0;
+    const int controlRate = 32;
+    const int numSamples = referenceBlock;
+
+    ThickSynth ts;
+    ChasingSynth cs;
+    ts.setSeed(1);
+    ts.setNoiseSeed(2);
+    cs.setSeed(3);
+    ts.prepare(SR, controlRate);
+    cs.prepare(SR, controlRate);
+
+    std::vector<float> cutoffs ((size_t)numSamples), resonances ((size_t)numSamples), pans ((size_t)numSamples);
+    out.assign((size_t)numSamples * 4, 0.0f);
+
+    // into the piece far enough for voices to be fading and the chase to be moving
+    for (int block = 0; block < 200; block++)
+    {
+        ts.renderBlock(out.data(), cutoffs.data(), resonances.data(), numSamples);
+        cs.renderBlock(out.data() + numSamples, pans.data(), cutoffs.data(), numSamples);
+    }
+
+    ts.prepare(SR, controlRate);
+    cs.prepare(SR, controlRate);
+
+    int before = ScopedAudioThreadCheck::getAllocations();
+
+    {
+        // counted like processBlock is (debug builds), see allocationCounter.h
+        ScopedAudioThreadCheck allocationCheck;
+
+        for (int p = 0; p < extraPrepares; p++)
+        {
+            ts.prepare(SR, controlRate);
+            cs.prepare(SR, controlRate);
+        }
+    }
+
+    int allocations = ScopedAudioThreadCheck::getAllocations() - before;
+
+    ts.renderBlock(out.data() + 2 * numSamples, cutoffs.data(), resonances.data(), numSamples);
+    cs.renderBlock(out.data() + 3 * numSamples, pans.data(), cutoffs.data(), numSamples);
+
+    return allocations;
+}
+
+static int checkRepeatedPrepare()
+{
+    std::vector<float> once, repeated;
+    renderAroundPrepares(0, once);
+    int allocations = renderAroundPrepares(preparePasses, repeated);
+
+    int mismatches = 0;
+
+    for (size_t i = 0; i < once.size(); i++)
+        if (std::memcmp(&once[i], &repeated[i], sizeof(float)) != 0)
+            mismatches++;
+
+    int failures = 0;
+
+    if (! engineResult("prepare() x " + juce::String(preparePasses + 1) + ", output", mismatches == 0,
+                       juce::String(mismatches) + " of " + juce::String((int)once.size()) + " samples differ from a single prepare()"))
+        failures++;
+
+   #if DRONE_CHECK_AUDIO_ALLOCATIONS
+    if (! engineResult("prepare() x " + juce::String(preparePasses) + ", same size, allocations", allocations == 0,
+                       juce::String(allocations) + " allocations"))
+        failures++;
+   #else
+    juce::ignoreUnused(allocations);
+    engineResult("prepare() x " + juce::String(preparePasses) + ", same size, allocations", true,
+                 "not counted, built with DRONE_CHECK_AUDIO_ALLOCATIONS 0");
+   #endif
+
+    return failures;
+}
+
+// every engine check, number of failures
+static int checkEngines()
+{
+    std::cout << "\nengines\n";
+
+    return checkOscillatorBank()
+         + checkSineEngines()
+         + checkAliasing()
+         + checkSeeking()
+         + checkRepeatedPrepare();
+}
+
+//==============================================================================
+// ---- SETTINGS ---- //
+
+struct GoldenSettings
+{
+    juce::File directory; // where the references live, defaultReferences() unless given
+    bool record = false;
+    bool exact = true; // bit exact, or within maxErrorDB and maxSpectralDB
+    double maxErrorDB = -60.0;
+    double maxSpectralDB = 1.0;
+    juce::Array<int> blocks; // block sizes to check, randomBlocks for random ones
+    juce::String caseName; // only this case, empty for all
+    bool requireReferences = false; // a missing reference fails, instead of checking the case against itself
+};
+
+// the references kept in the repository, Golden/references next to this file
+static juce::File defaultReferences()
+{
+    return juce::File(__FILE__).getSiblingFile("references");
+}
+
+static void printUsage()
+{
+    std::cout << "drone_golden: renders fixed seed segments of the drone and compares them with stored references\n\n"
+              << "  --record [dir]       render the references (at " << referenceBlock << " sample blocks) into dir\n"
+              << "  --check [dir]        compare against the references in dir, at every block size, then run the engine checks\n"
+              << "                       dir defaults to the repository's references, " << defaultReferences().getFullPathName() << "\n"
+              << "  --mode <mode>        exact (bit for bit, default) or tolerance\n"
+              << "  --max-error <dB>     tolerance: difference energy relative to the reference (default -60)\n"
+              << "  --max-spectral <dB>  tolerance: log spectral distance (default 1)\n"
+              << "  --blocks <list>      block sizes to check, comma separated, \"random\" for random sizes 1 - " << maxBlock << "\n"
+              << "                       (default 1,2,3,7,31,32,33,64,127,441,512,1000,1024,2048,4096,random)\n"
+              << "  --case <name>        only this case\n"
+              << "  --require-references a missing reference fails (otherwise the case is checked against its own "
+              << referenceBlock << " sample render)\n\n"
+              << "cases:\n";
+
+    for (const auto& c : goldenCases)
+        std::cout << "  " << juce::String(c.name).paddedRight(' ', 20) << " seed " << c.seed << ", " << c.sampleRate << " Hz, "
+                  << c.lengthSeconds << " s from " << c.startSeconds << " s, "
+                  << (c.reverbLines > 0 ? "FDN " + juce::String(c.reverbLines) : juce::String("freeverb"))
+                  << ", oversampling " << c.oversample << ", chasers " << c.chasers << "\n";
+}
+
+static bool parseArguments(const juce::ArgumentList& args, GoldenSettings& settings)
+{
+    settings.record = args.containsOption("--record");
+
+    if (settings.record == args.containsOption("--check"))
+        return false; // one or the other
+
+    auto dir = args.getValueForOption(settings.record ? "--record" : "--check");
+    settings.directory = dir.isEmpty() ? defaultReferences() : juce::File::getCurrentWorkingDirectory().getChildFile(dir);
+
+    if (args.containsOption("--mode"))
+    {
+        auto mode = args.getValueForOption("--mode");
+
+        if (mode != "exact" && mode != "tolerance")
+            return false;
+
+        settings.exact = mode == "exact";
+    }
+
+    if (args.containsOption("--max-error"))
+        settings.maxErrorDB = args.getValueForOption("--max-error").getDoubleValue();
+
+    if (args.containsOption("--max-spectral"))
+        settings.maxSpectralDB = args.getValueForOption("--max-spectral").getDoubleValue();
+
+    if (args.containsOption("--blocks"))
+    {
+        for (auto& block : juce::StringArray::fromTokens(args.getValueForOption("--blocks"), ",", ""))
+        {
+            int size = block.trim() == "random" ? randomBlocks : block.getIntValue();
+
+            if (size != randomBlocks && (size < 1 || size > maxBlock))
+                return false;
+
+            settings.blocks.add(size);
+        }
+    }
+    else
+    {
+        for (int size : defaultBlocks)
+            settings.blocks.add(size);
+    }
+
+    settings.caseName = args.getValueForOption("--case");
+    settings.requireReferences = args.containsOption("--require-references");
+    return settings.blocks.size() > 0;
+}
+
+//==============================================================================
+// ---- RECORD / CHECK ---- //
+
+static int record(const GoldenSettings& settings)
+{
+    if (! settings.directory.createDirectory())
+    {
+        std::cerr << "couldn't create " << settings.directory.getFullPathName() << "\n";
+        return 1;
+    }
+
+    for (const auto& c : goldenCases)
+    {
+        if (settings.caseName.isNotEmpty() && settings.caseName != c.name)
+            continue;
+
+        juce::AudioBuffer<float> audio;
+        renderCase(c, referenceBlock, audio);
+
+        auto file = settings.directory.getChildFile(juce::String(c.name) + ".wav");
+
+        if (! writeReference(file, audio, c.sampleRate))
+        {
+            std::cerr << "couldn't write " << file.getFullPathName() << "\n";
+            return 1;
+        }
+
+        std::cout << "recorded " << file.getFullPathName() << "\n";
+    }
+
+    return 0;
+}
+
+static int check(const GoldenSettings& settings)
+{
+    std::cout << "checking against " << settings.directory.getFullPathName() << ", "
+              << (settings.exact ? juce::String("bit exact")
+                                 : "tolerance, error under " + juce::String(settings.maxErrorDB, 1) + " dB, spectral distance under "
+                                   + juce::String(settings.maxSpectralDB, 2) + " dB")
+              << "\n\n"
+              << juce::String("case").paddedRight(' ', 20) << juce::String("block").paddedLeft(' ', 8)
+              << juce::String("result").paddedLeft(' ', 8) << juce::String("mismatches").paddedLeft(' ', 12)
+              << juce::String("first at").paddedLeft(' ', 10) << juce::String("error dB").paddedLeft(' ', 10)
+              << juce::String("peak dB").paddedLeft(' ', 10) << juce::String("spectral").paddedLeft(' ', 10) << "\n";
+
+    int failures = 0, checks = 0, unreferenced = 0;
+
+    for (const auto& c : goldenCases)
+    {
+        if (settings.caseName.isNotEmpty() && settings.caseName != c.name)
+            continue;
+
+        auto file = settings.directory.getChildFile(juce::String(c.name) + ".wav");
+        juce::AudioBuffer<float> reference;
+        double referenceRate = 0.0;
+
+        if (! file.existsAsFile() || ! readReference(file, reference, referenceRate))
+        {
+            if (settings.requireReferences)
+            {
+                std::cerr << "no reference for " << c.name << " (" << file.getFullPathName() << "), record it with --record from a known good revision\n";
+                return 1;
+            }
+
+            // nothing recorded yet: still catches block size bugs, against this build's own render at referenceBlock
+            std::cout << c.name << ": no reference recorded, checking block sizes against a " << referenceBlock << " sample render of this build\n";
+            renderCase(c, referenceBlock, reference);
+            referenceRate = c.sampleRate;
+            unreferenced++;
+        }
+
+        for (int blockSize : settings.blocks)
+        {
+            juce::AudioBuffer<float> test;
+            renderCase(c, blockSize, test);
+            checks++;
+
+            bool sameShape = referenceRate == c.sampleRate
+                          && reference.getNumChannels() == test.getNumChannels()
+                          && reference.getNumSamples() == test.getNumSamples();
+
+            if (! sameShape)
+            {
+                std::cout << juce::String(c.name).paddedRight(' ', 20) << blockName(blockSize).paddedLeft(' ', 8)
+                          << "    FAIL  reference is a different rate, length or channel count, record it again\n";
+                failures++;
+                continue;
+            }
+
+            auto result = compare(reference, test);
+
+            bool pass = settings.exact ? result.mismatches == 0
+                                       : result.errorDB <= settings.maxErrorDB && result.spectralDB <= settings.maxSpectralDB;
+
+            if (! pass)
+                failures++;
+
+            std::cout << juce::String(c.name).paddedRight(' ', 20) << blockName(blockSize).paddedLeft(' ', 8)
+                      << juce::String(pass ? "ok" : "FAIL").paddedLeft(' ', 8)
+                      << juce::String(result.mismatches).paddedLeft(' ', 12)
+                      << (result.firstMismatch < 0 ? juce::String("-") : juce::String(result.firstMismatch)).paddedLeft(' ', 10)
+                      << formatDB(result.errorDB).paddedLeft(' ', 10)
+                      << formatDB(result.peakErrorDB).paddedLeft(' ', 10)
+                      << juce::String(result.spectralDB, 3).paddedLeft(' ', 10) << "\n";
+        }
+    }
+
+    std::cout << "\n" << (checks - failures) << " of " << checks << " passed\n";
+
+    if (unreferenced > 0)
+        std::cout << unreferenced << " case(s) had no reference, so only block size consistency was checked, record them with --record\n";
+
+    failures += checkEngines();
+
+    // debug builds count every allocation inside processBlock, see allocationCounter.h
+    if (ScopedAudioThreadCheck::getAllocations() > 0)
+    {
+        std::cout << "FAIL  processBlock allocated " << ScopedAudioThreadCheck::getAllocations() << " times\n";
+        failures++;
+    }
+
+    return failures == 0 ? 0 : 1;
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInit; // the processor expects a message manager to exist
+
+    juce::ArgumentList args (argc, argv);
+    GoldenSettings settings;
+
+    if (args.containsOption("--help|-h"))
+    {
+        printUsage();
+        return 0;
+    }
+
+    if (! parseArguments(args, settings))
+    {
+        printUsage();
+        return 2;
+    }
+
+    return settings.record ? record(settings) : check(settings);
+}
@@ -0,0 +1,348 @@
+/*
+  ==============================================================================
+
+    Offline renderer for the drone.
+    Runs Drone_pieceAudioProcessor headless as fast as the CPU allows
+    and streams the result to a WAV or FLAC file.
+    Several drones can be rendered at once (DroneEngine), each on its own output pair.
+
+    usage: drone_render --out drone.wav [--length 3600] [--start 0] [--rate 48000]
+                        [--block 512] [--bits 24] [--seed 1]
+                        [--instances 1] [--channels 2] [--threads n]
+                        [--oversample 1] [--reverb freeverb] [--chasers 1] [--log events.txt]
+           drone_render --scaling [--length 10]
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../Source/PluginProcessor.h"
+#include "../Source/droneEngine.h"
+#include "../Source/allocationCounter.h"
+
+//==============================================================================
+// ---- SETTINGS ---- //
+
+struct RenderSettings
+{
+    juce::File outFile;
+    double lengthSeconds = 60.0;
+    double startSeconds = 0.0; // how far into the piece the file starts
+    double sampleRate = 48000.0;
+    int blockSize = 512;
+    int bitDepth = 24;
+    juce::int64 seed = 1;
+    int instances = 1; // drones, seeded seed, seed + 1...
+    int channels = 2; // output channels
+    int threads = 1;
+    int oversample = 1; // chase synth distortion oversampling
+    int reverbLines = 0; // 0 = juce::Reverb, 4 / 8 / 16 = FdnReverb
+    int chasers = 1; // 1 = chase synth, more = ChaseSwarm
+    juce::String logFile; // event log, "-" for stdout, empty for none
+};
+
+static void printUsage()
+{
+    std::cout << "drone_render: renders the drone offline, faster than real time\n\n"
+              << "  --out <file>       output file, .wav or .flac (required)\n"
+              << "  --length <secs>    length in seconds (default 60)\n"
+              << "  --start <secs>     seek this far into the piece first, without rendering it (default 0)\n"
+              << "  --rate <hz>        sample rate (default 48000)\n"
+              << "  --block <samples>  block size passed to processBlock (default 512)\n"
+              << "  --bits <16|24>     bit depth (default 24)\n"
+              << "  --seed <n>         random seed (default 1)\n"
+              << "  --instances <n>    drones rendered side by side, each on its own output pair (default 1)\n"
+              << "  --channels <n>     output channels (default 2)\n"
+              << "  --threads <n>      render threads (default: one per core)\n"
+              << "  --oversample <n>   chase synth distortion oversampling, 1, 2 or 4 (default 1)\n"
+              << "  --reverb <engine>  freeverb, fdn4, fdn8 or fdn16 (default freeverb)\n"
+              << "  --chasers <n>      chase synths, 1 - " << ChaseSwarm::maxChasers << ", more than 1 renders a swarm (default 1)\n"
+              << "  --log <file>       trace catches, gain LFO and partial count changes, - for stdout\n"
+              << "                     (more than one drone: one file each, numbered)\n"
+              << "  --scaling          benchmark 1 - 64 drones on 1 thread and on every core, no file written\n";
+}
+
+// reads the command line into settings, false if something is out of range
+static bool parseArguments(const juce::ArgumentList& args, RenderSettings& settings)
+{
+    if (args.containsOption("--out"))
+        settings.outFile = juce::File::getCurrentWorkingDirectory().getChildFile(args.getValueForOption("--out"));
+
+    if (args.containsOption("--length"))
+        settings.lengthSeconds = args.getValueForOption("--length").getDoubleValue();
+
+    if (args.containsOption("--start"))
+        settings.startSeconds = args.getValueForOption("--start").getDoubleValue();
+
+    if (args.containsOption("--rate"))
+        settings.sampleRate = args.getValueForOption("--rate").getDoubleValue();
+
+    if (args.containsOption("--block"))
+        settings.blockSize = args.getValueForOption("--block").getIntValue();
+
+    if (args.containsOption("--bits"))
+        settings.bitDepth = args.getValueForOption("--bits").getIntValue();
+
+    if (args.containsOption("--seed"))
+        settings.seed = args.getValueForOption("--seed").getLargeIntValue();
+
+    if (args.containsOption("--instances"))
+        settings.instances = args.getValueForOption("--instances").getIntValue();
+
+    if (args.containsOption("--channels"))
+        settings.channels = args.getValueForOption("--channels").getIntValue();
+
+    settings.threads = juce::SystemStats::getNumCpus();
+
+    if (args.containsOption("--threads"))
+        settings.threads = args.getValueForOption("--threads").getIntValue();
+
+    if (args.containsOption("--oversample"))
+        settings.oversample = args.getValueForOption("--oversample").getIntValue();
+
+    if (args.containsOption("--chasers"))
+        settings.chasers = args.getValueForOption("--chasers").getIntValue();
+
+    if (args.containsOption("--log"))
+        settings.logFile = args.getValueForOption("--log");
+
+    if (args.containsOption("--reverb"))
+    {
+        auto engine = args.getValueForOption("--reverb");
+
+        if (engine == "fdn4" || engine == "fdn8" || engine == "fdn16")
+            settings.reverbLines = engine.getTrailingIntValue();
+        else if (engine != "freeverb")
+            return false;
+    }
+
+    return settings.lengthSeconds > 0.0
+        && settings.startSeconds >= 0.0
+        && settings.sampleRate >= 8000.0
+        && settings.blockSize > 0
+        && (settings.bitDepth == 16 || settings.bitDepth == 24)
+        && settings.instances > 0
+        && settings.channels > 0
+        && settings.threads > 0
+        && (settings.oversample == 1 || settings.oversample == 2 || settings.oversample == 4)
+        && settings.chasers >= 1 && settings.chasers <= ChaseSwarm::maxChasers;
+}
+
+//==============================================================================
+// ---- OUTPUT FILE ---- //
+
+// picks WAV or FLAC from the file extension
+static std::unique_ptr<juce::AudioFormat> formatForFile(const juce::File& file)
+{
+    if (file.hasFileExtension("flac"))
+        return std::make_unique<juce::FlacAudioFormat>();
+
+    if (file.hasFileExtension("wav"))
+        return std::make_unique<juce::WavAudioFormat>();
+
+    return nullptr;
+}
+
+static std::unique_ptr<juce::AudioFormatWriter> createWriter(juce::AudioFormat& format, const RenderSettings& settings)
+{
+    settings.outFile.deleteFile();
+    auto stream = settings.outFile.createOutputStream();
+
+    if (stream == nullptr)
+        return nullptr;
+
+    std::unique_ptr<juce::AudioFormatWriter> writer (format.createWriterFor(stream.get(), settings.sampleRate,
+                                                                           (unsigned int)settings.channels,
+                                                                           settings.bitDepth, {}, 0));
+
+    if (writer != nullptr)
+        stream.release(); // writer owns the stream now
+
+    return writer;
+}
+
+//==============================================================================
+// ---- RENDER ---- //
+
+static int render(const RenderSettings& settings)
+{
+    auto format = formatForFile(settings.outFile);
+
+    if (format == nullptr)
+    {
+        std::cerr << "output file must end in .wav or .flac\n";
+        return 1;
+    }
+
+    auto writer = createWriter(*format, settings);
+
+    if (writer == nullptr)
+    {
+        std::cerr << "couldn't open " << settings.outFile.getFullPathName() << " for writing\n";
+        return 1;
+    }
+
+    // disk writes and FLAC encoding run on their own thread, so rendering never waits on them
+    juce::TimeSliceThread writerThread ("drone_render writer");
+    writerThread.startThread();
+    auto threadedWriter = std::make_unique<juce::AudioFormatWriter::ThreadedWriter>(writer.release(), writerThread, 1 << 18);
+
+    DroneEngine engine;
+    engine.setDistortionOversampling(settings.oversample);
+    engine.setReverbEngine(settings.reverbLines);
+    engine.setChasers(settings.chasers);
+    engine.prepare(settings.instances, settings.channels, settings.sampleRate, settings.blockSize, settings.threads, settings.seed);
+
+    for (int i = 0; settings.logFile.isNotEmpty() && i < engine.getNumInstances(); i++)
+    {
+        juce::File logFile;
+
+        if (settings.logFile != "-")
+        {
+            logFile = juce::File::getCurrentWorkingDirectory().getChildFile(settings.logFile);
+
+            if (engine.getNumInstances() > 1)
+                logFile = logFile.getSiblingFile(logFile.getFileNameWithoutExtension() + "_" + juce::String(i + 1) + logFile.getFileExtension());
+        }
+
+        if (! engine.getInstance(i)->startEventLog(logFile))
+        {
+            std::cerr << "couldn't open " << logFile.getFullPathName() << " for the event log\n";
+            return 1;
+        }
+    }
+
+    if (settings.startSeconds > 0.0)
+    {
+        auto seekStart = juce::Time::getHighResolutionTicks();
+
+        for (int i = 0; i < engine.getNumInstances(); i++)
+            engine.getInstance(i)->seekTo(settings.startSeconds);
+
+        std::cout << "seeked " << settings.startSeconds << " s into the piece in "
+                  << juce::String(juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - seekStart), 3) << " s\n";
+    }
+
+    juce::AudioBuffer<float> buffer (settings.channels, settings.blockSize);
+
+    auto totalSamples = (juce::int64)std::llround(settings.lengthSeconds * settings.sampleRate);
+    auto progressInterval = (juce::int64)(settings.sampleRate * 600.0); // print every 10 minutes of audio
+    auto nextProgress = progressInterval;
+
+    std::cout << "rendering " << settings.lengthSeconds << " s at " << settings.sampleRate << " Hz, "
+              << settings.blockSize << " sample blocks, seed " << settings.seed << ", "
+              << engine.getNumInstances() << " drone(s) on " << engine.getNumThreads() << " thread(s), "
+              << settings.channels << " channels -> " << settings.outFile.getFullPathName() << "\n";
+
+    auto start = juce::Time::getHighResolutionTicks();
+    double renderSeconds = 0.0; // time spent rendering only
+
+    for (juce::int64 done = 0; done < totalSamples;)
+    {
+        int numSamples = (int)juce::jmin((juce::int64)settings.blockSize, totalSamples - done);
+        buffer.setSize(buffer.getNumChannels(), numSamples, false, false, true);
+
+        auto blockStart = juce::Time::getHighResolutionTicks();
+        engine.process(buffer);
+        renderSeconds += juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - blockStart);
+
+        // FIFO full, give the writer thread a moment to catch up
+        while (! threadedWriter->write(buffer.getArrayOfReadPointers(), numSamples))
+            juce::Thread::sleep(1);
+
+        done += numSamples;
+
+        if (done >= nextProgress)
+        {
+            std::cout << "  " << juce::String(done / settings.sampleRate / 60.0, 1) << " min\n";
+            nextProgress += progressInterval;
+        }
+    }
+
+    threadedWriter.reset(); // flushes whatever is still queued, so the timing below includes it
+
+    auto wallSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+    double audioSeconds = totalSamples / settings.sampleRate;
+
+    std::cout << "done: " << juce::String(audioSeconds, 1) << " s of audio in " << juce::String(wallSeconds, 2) << " s\n"
+              << "  real time factor " << juce::String(audioSeconds / juce::jmax(wallSeconds, 1.0e-9), 1) << "x overall, "
+              << juce::String(audioSeconds / juce::jmax(renderSeconds, 1.0e-9), 1) << "x rendering\n";
+
+    return 0;
+}
+
+//==============================================================================
+// ---- SCALING BENCHMARK ---- //
+
+// seconds to render lengthSeconds of audio with this many drones and threads
+static double timeEngine(const RenderSettings& settings, int instances, int threads)
+{
+    DroneEngine engine;
+    engine.setDistortionOversampling(settings.oversample);
+    engine.setReverbEngine(settings.reverbLines);
+    engine.setChasers(settings.chasers);
+    engine.prepare(instances, 2, settings.sampleRate, settings.blockSize, threads, settings.seed);
+
+    juce::AudioBuffer<float> buffer (2, settings.blockSize);
+    auto totalSamples = (juce::int64)(settings.lengthSeconds * settings.sampleRate);
+
+    auto start = juce::Time::getHighResolutionTicks();
+
+    for (juce::int64 done = 0; done < totalSamples; done += settings.blockSize)
+        engine.process(buffer);
+
+    return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+}
+
+// real time factor for 1 - 64 drones, single threaded and on every core
+static int scaling(const RenderSettings& settings)
+{
+    int cores = juce::SystemStats::getNumCpus();
+
+    std::cout << "scaling: " << settings.lengthSeconds << " s per run, " << settings.blockSize
+              << " sample blocks, " << cores << " cores\n\n"
+              << "drones" << juce::String("1 thread").paddedLeft(' ', 16)
+              << juce::String(juce::String(cores) + " threads").paddedLeft(' ', 16)
+              << juce::String("speedup").paddedLeft(' ', 10) << "\n";
+
+    for (int instances : { 1, 2, 4, 8, 16, 32, 64 })
+    {
+        double single = timeEngine(settings, instances, 1);
+        double parallel = timeEngine(settings, instances, cores);
+
+        std::cout << juce::String(instances).paddedRight(' ', 6)
+                  << (juce::String(settings.lengthSeconds / single, 1) + "x rt").paddedLeft(' ', 16)
+                  << (juce::String(settings.lengthSeconds / parallel, 1) + "x rt").paddedLeft(' ', 16)
+                  << (juce::String(single / parallel, 2) + "x").paddedLeft(' ', 10) << "\n";
+    }
+
+    return 0;
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInit; // processors expect a message manager to exist
+
+    juce::ArgumentList args (argc, argv);
+    RenderSettings settings;
+
+    if (args.containsOption("--help|-h"))
+    {
+        printUsage();
+        return 0;
+    }
+
+    bool scalingRun = args.containsOption("--scaling");
+
+    if (scalingRun)
+        settings.lengthSeconds = 10.0; // default per run, --length still overrides
+
+    if (! parseArguments(args, settings) || (! scalingRun && ! args.containsOption("--out")))
+    {
+        printUsage();
+        return 1;
+    }
+
+    return scalingRun ? scaling(settings) : render(settings);
+}
@@ -11,15 +11,32 @@
 
 //==============================================================================
 Drone_pieceAudioProcessorEditor::Drone_pieceAudioProcessorEditor (Drone_pieceAudioProcessor& p)
-    : AudioProcessorEditor (&p), audioProcessor (p)
+    : AudioProcessorEditor (&p), audioProcessor (p), telemetry (p.getTelemetry())
 {
     // Make sure that before the constructor has finished, you've set the
     // editor's size to whatever you need it to be.
-    setSize (400, 300);
+    setSize (720, 560);
+    
+    // everything the telemetry hands over gets copied into these, nothing's allocated on the timer
+    incoming.resize(Telemetry::sampleCapacity);
+    history.assign(fftSize, 0.0f);
+    fftData.assign(fftSize * 2, 0.0f);
+    spectrum.assign(fftSize / 2, spectrumFloor);
+    
+    // profiler table, histograms start over from the next block
+    resetButton.onClick = [this] { audioProcessor.resetProfiler(); };
+    resetButton.setEnabled (StageProfiler::isEnabled());
+    addAndMakeVisible (resetButton);
+    
+    // the audio thread only sends anything while the editor's open
+    telemetry.setActive(true);
+    startTimerHz (frameRateHz);
 }
 
 Drone_pieceAudioProcessorEditor::~Drone_pieceAudioProcessorEditor()
 {
+    stopTimer();
+    telemetry.setActive(false);
 }
 
 //==============================================================================
@@ -27,14 +44,236 @@ void Drone_pieceAudioProcessorEditor::paint (juce::Graphics& g)
 {
     // (Our component is opaque, so we must completely fill the background with a solid colour)
     g.fillAll (getLookAndFeel().findColour (juce::ResizableWindow::backgroundColourId));
+    
+    auto area = getLocalBounds().reduced (12);
+    
+    auto top = area.removeFromTop (180);
+    paintScope (g, top.removeFromLeft ((top.getWidth() - 12) / 2));
+    top.removeFromLeft (12);
+    paintSpectrum (g, top);
+    
+    area.removeFromTop (8);
+    paintState (g, area.removeFromTop (110));
+    
+    area.removeFromTop (8);
+    paintProfiler (g, area);
+}
+
+// output waveform, starting on a rising zero crossing so it holds still
+void Drone_pieceAudioProcessorEditor::paintScope (juce::Graphics& g, juce::Rectangle<int> area)
+{
+    g.setColour (juce::Colours::black);
+    g.fillRect (area);
+    
+    int start = fftSize - scopeSamples;
+    for (int i = fftSize - 2 * scopeSamples + 1; i < fftSize - scopeSamples; i++)
+    {
+        if (history[i - 1] < 0.0f && history[i] >= 0.0f)
+        {
+            start = i;
+            break;
+        }
+    }
+    
+    auto bounds = area.toFloat();
+    juce::Path wave;
+    
+    for (int i = 0; i < scopeSamples; i++)
+    {
+        float x = bounds.getX() + bounds.getWidth() * i / (float)(scopeSamples - 1);
+        float y = bounds.getCentreY() - juce::jlimit(-1.0f, 1.0f, history[start + i]) * bounds.getHeight() * 0.5f;
+        
+        if (i == 0)
+            wave.startNewSubPath (x, y);
+        else
+            wave.lineTo (x, y);
+    }
+    
+    g.setColour (juce::Colours::lightgreen);
+    g.strokePath (wave, juce::PathStrokeType (1.0f));
+    
+    g.setColour (juce::Colours::white);
+    g.setFont (13.0f);
+    g.drawText ("output", area.reduced (4), juce::Justification::topLeft);
+}
+
+// log frequency, 20 Hz up to half the telemetry rate, spectrumFloor to 0 dB
+void Drone_pieceAudioProcessorEditor::paintSpectrum (juce::Graphics& g, juce::Rectangle<int> area)
+{
+    g.setColour (juce::Colours::black);
+    g.fillRect (area);
+    
+    auto bounds = area.toFloat();
+    double nyquist = telemetry.getScopeSampleRate() * 0.5;
+    double minFreq = 20.0;
+    juce::Path path;
+    bool started = false;
+    
+    for (int bin = 1; bin < fftSize / 2; bin++)
+    {
+        double freq = bin * nyquist / (fftSize / 2);
+        
+        if (freq < minFreq)
+            continue;
+        
+        float x = bounds.getX() + bounds.getWidth() * (float)(std::log(freq / minFreq) / std::log(nyquist / minFreq));
+        float y = bounds.getY() + bounds.getHeight() * juce::jlimit(0.0f, 1.0f, spectrum[bin] / spectrumFloor);
+        
+        if (! started)
+            path.startNewSubPath (x, y);
+        else
+            path.lineTo (x, y);
+        
+        started = true;
+    }
+    
+    g.setColour (juce::Colours::orange);
+    g.strokePath (path, juce::PathStrokeType (1.0f));
+    
+    g.setColour (juce::Colours::white);
+    g.setFont (13.0f);
+    g.drawText ("spectrum, 20 Hz - " + juce::String (nyquist / 1000.0, 1) + " kHz", area.reduced (4), juce::Justification::topLeft);
+}
+
+// both synths as of the newest State, gain LFO rates as bars, one per sounding partial
+void Drone_pieceAudioProcessorEditor::paintState (juce::Graphics& g, juce::Rectangle<int> area)
+{
+    g.setColour (juce::Colours::white);
+    g.setFont (13.0f);
+    
+    if (! hasState)
+    {
+        g.drawText ("waiting for audio", area, juce::Justification::centredLeft);
+        return;
+    }
+    
+    const auto& st = telemetryState;
+    auto text = area.removeFromLeft (area.getWidth() / 2);
+    double seconds = st.time / juce::jmax(1.0, telemetry.getScopeSampleRate() * Telemetry::decimation);
+    
+    juce::String minutes = juce::String ((int)seconds / 60) + ":" + juce::String ((int)seconds % 60).paddedLeft ('0', 2);
+    g.drawText ("piece at " + minutes, text.removeFromTop (rowHeight), juce::Justification::centredLeft);
+    g.drawText ("thick synth  " + juce::String (st.oscCount) + " partials on " + juce::String (st.vectorFreq, 1) + " Hz",
+                text.removeFromTop (rowHeight), juce::Justification::centredLeft);
+    g.drawText ("filter  " + juce::String (st.cutoff, 0) + " Hz, resonance " + juce::String (st.resonance, 2),
+                text.removeFromTop (rowHeight), juce::Justification::centredLeft);
+    g.drawText ("chase synth  " + juce::String (st.chaseFreq, 0) + " Hz -> " + juce::String (st.chaseTarget, 0) + " Hz, pan "
+                + juce::String (st.chasePan, 2), text.removeFromTop (rowHeight), juce::Justification::centredLeft);
+    
+    if (auto dropped = telemetry.getDroppedSamples())
+        g.drawText (juce::String ((int)dropped) + " samples dropped", text.removeFromTop (rowHeight), juce::Justification::centredLeft);
+    
+    // gain LFO's, tallest is the fastest
+    g.drawText ("gain LFO's", area.removeFromTop (rowHeight), juce::Justification::centredLeft);
+    
+    float fastest = 0.0f;
+    for (int i = 0; i < st.oscCount; i++)
+        fastest = juce::jmax(fastest, std::abs(st.gainLFOFreqs[i]));
+    
+    auto bars = area.toFloat();
+    float barWidth = bars.getWidth() / (float)juce::jmax(1, st.oscCount);
+    
+    g.setColour (juce::Colours::lightblue);
+    for (int i = 0; i < st.oscCount; i++)
+    {
+        float height = fastest > 0.0f ? bars.getHeight() * std::abs(st.gainLFOFreqs[i]) / fastest : 0.0f;
+        g.fillRect (bars.getX() + i * barWidth + 1.0f, bars.getBottom() - height, barWidth - 2.0f, height);
+    }
+}
 
+// stage name | min | mean | p99 | max (microseconds per block) | mean share of the time a block has
+void Drone_pieceAudioProcessorEditor::paintProfiler (juce::Graphics& g, juce::Rectangle<int> area)
+{
     g.setColour (juce::Colours::white);
     g.setFont (15.0f);
-    g.drawFittedText ("Hello World!", getLocalBounds(), juce::Justification::centred, 1);
+    g.drawFittedText ("processBlock, microseconds per block", area.removeFromTop (rowHeight), juce::Justification::centredLeft, 1);
+    
+    if (! StageProfiler::isEnabled())
+    {
+        g.drawFittedText ("profiling compiled out (DRONE_PROFILING=0)", area, juce::Justification::centred, 1);
+        return;
+    }
+    
+    // time one block has, for the load column
+    double blockMicros = audioProcessor.getSampleRate() > 0.0
+                       ? audioProcessor.getBlockSize() * 1.0e6 / audioProcessor.getSampleRate() : 0.0;
+    
+    auto drawRow = [&g, &area] (const juce::StringArray& cells)
+    {
+        auto row = area.removeFromTop (rowHeight);
+        g.drawFittedText (cells[0], row.removeFromLeft (140), juce::Justification::centredLeft, 1);
+        
+        for (int i = 1; i < cells.size(); i++)
+            g.drawFittedText (cells[i], row.removeFromLeft (70), juce::Justification::centredRight, 1);
+    };
+    
+    g.setFont (13.0f);
+    drawRow ({ "stage", "min", "mean", "p99", "max", "load" });
+    
+    for (int s = 0; s < StageProfiler::numStages; s++)
+    {
+        const auto& st = stats[s];
+        juce::String load = blockMicros > 0.0 ? juce::String (100.0 * st.mean / blockMicros, 1) + " %" : "-";
+        
+        drawRow ({ StageProfiler::getStageName (s),
+                   juce::String (st.min, 1), juce::String (st.mean, 1), juce::String (st.p99, 1), juce::String (st.max, 1),
+                   load });
+    }
+    
+    g.drawFittedText (juce::String ((juce::int64)stats[StageProfiler::blockStage].blocks) + " blocks",
+                      area.removeFromTop (rowHeight), juce::Justification::centredLeft, 1);
 }
 
 void Drone_pieceAudioProcessorEditor::resized()
 {
     // This is generally where you'll want to lay out the positions of any
     // subcomponents in your editor..
+    resetButton.setBounds (getWidth() - 92, getHeight() - 36, 80, 24);
+}
+
+// pulls whatever the audio thread sent since the last frame, then redraws
+void Drone_pieceAudioProcessorEditor::timerCallback()
+{
+    int numNew = telemetry.readSamples(incoming.data(), (int)incoming.size());
+    
+    if (numNew > 0)
+    {
+        // newest fftSize samples, oldest first
+        int keep = juce::jmax(0, fftSize - numNew);
+        std::copy(history.end() - keep, history.end(), history.begin());
+        
+        int take = fftSize - keep;
+        std::copy(incoming.begin() + (numNew - take), incoming.begin() + numNew, history.begin() + keep);
+        
+        updateSpectrum();
+    }
+    
+    if (telemetry.readState(telemetryState))
+        hasState = true;
+    
+    if (--framesToProfile <= 0)
+    {
+        for (int s = 0; s < StageProfiler::numStages; s++)
+            stats[s] = audioProcessor.getStageStats (s);
+        
+        framesToProfile = frameRateHz / refreshHz;
+    }
+    
+    repaint();
+}
+
+void Drone_pieceAudioProcessorEditor::updateSpectrum()
+{
+    std::copy(history.begin(), history.end(), fftData.begin());
+    std::fill(fftData.begin() + fftSize, fftData.end(), 0.0f);
+    
+    window.multiplyWithWindowingTable(fftData.data(), (size_t)fftSize);
+    fft.performFrequencyOnlyForwardTransform(fftData.data());
+    
+    // full scale sine = 0 dB (the window's normalised to sum to fftSize), peaks fall back slowly
+    for (int bin = 0; bin < fftSize / 2; bin++)
+    {
+        float dB = juce::Decibels::gainToDecibels(fftData[bin] * 2.0f / fftSize, spectrumFloor);
+        spectrum[bin] = juce::jmax(dB, spectrum[bin] - spectrumFall);
+    }
 }
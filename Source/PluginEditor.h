@@ -13,8 +13,12 @@
 
 //==============================================================================
 /**
+ A window on the drone: scope and spectrum of the output, what both synths are doing (see Telemetry),
+ and where processBlock's time goes, a row per stage (see StageProfiler).
+ Everything comes from the processor through lock-free rings, read on a timer, so the audio thread never waits on the editor.
 */
-class Drone_pieceAudioProcessorEditor  : public juce::AudioProcessorEditor
+class Drone_pieceAudioProcessorEditor  : public juce::AudioProcessorEditor,
+                                         private juce::Timer
 {
 public:
     Drone_pieceAudioProcessorEditor (Drone_pieceAudioProcessor&);
@@ -25,9 +29,42 @@ public:
     void resized() override;
 
 private:
+    void timerCallback() override;
+    void updateSpectrum(); // FFT of the history, message thread
+    
+    void paintScope (juce::Graphics& g, juce::Rectangle<int> area);
+    void paintSpectrum (juce::Graphics& g, juce::Rectangle<int> area);
+    void paintState (juce::Graphics& g, juce::Rectangle<int> area);
+    void paintProfiler (juce::Graphics& g, juce::Rectangle<int> area);
+    
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
     Drone_pieceAudioProcessor& audioProcessor;
+    
+    // ---- telemetry ---- //
+    static constexpr int frameRateHz = 30; // redraws per second, whatever the audio thread sends
+    static constexpr int fftOrder = 11;
+    static constexpr int fftSize = 1 << fftOrder; // samples in the spectrum and the history (at the decimated rate)
+    static constexpr int scopeSamples = fftSize / 2; // samples across the scope, the rest is room to find a trigger
+    static constexpr float spectrumFloor = -100.0f; // dB
+    static constexpr float spectrumFall = 1.5f; // dB per frame peaks fall back
+    
+    Telemetry& telemetry;
+    std::vector<float> incoming; // read from the telemetry each frame
+    std::vector<float> history; // last fftSize samples, oldest first
+    juce::dsp::FFT fft { fftOrder };
+    juce::dsp::WindowingFunction<float> window { (size_t)fftSize, juce::dsp::WindowingFunction<float>::hann };
+    std::vector<float> fftData; // 2 * fftSize, the FFT works in place
+    std::vector<float> spectrum; // dB per bin
+    Telemetry::State telemetryState; // newest from the audio thread
+    bool hasState = false;
+    
+    // ---- profiler ---- //
+    StageProfiler::Stats stats[StageProfiler::numStages]; // latest from the processor, read on the timer
+    juce::TextButton resetButton { "Reset" };
+    static constexpr int refreshHz = 4; // profiler table, slower so the numbers can be read
+    int framesToProfile = 0;
+    static constexpr int rowHeight = 22;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Drone_pieceAudioProcessorEditor)
 };
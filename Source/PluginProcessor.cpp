@@ -9,7 +9,6 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 
-
 //==============================================================================
 Drone_pieceAudioProcessor::Drone_pieceAudioProcessor()
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -20,9 +19,47 @@ Drone_pieceAudioProcessor::Drone_pieceAudioProcessor()
 #endif
                   .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
 #endif
-                  )
+                  ),
+#else
+:
 #endif
+  parameters (*this, nullptr, "PARAMETERS", createParameterLayout())
 {
+    // new piece every time the plugin loads, unless a seed is set
+    randomSource.setSeed(juce::Random::getSystemRandom().nextInt64());
+    
+    // the audio thread only ever reads these
+    thickGainParam = parameters.getRawParameterValue("thickGain");
+    chaseGainParam = parameters.getRawParameterValue("chaseGain");
+    echoGainParam = parameters.getRawParameterValue("echoGain");
+    vectorFreqParam = parameters.getRawParameterValue("vectorFreq");
+    lfoFreq1Param = parameters.getRawParameterValue("lfoFreq1");
+    lfoFreq2Param = parameters.getRawParameterValue("lfoFreq2");
+    roomSizeParam = parameters.getRawParameterValue("roomSize");
+    dampingParam = parameters.getRawParameterValue("damping");
+    wetLevelParam = parameters.getRawParameterValue("wetLevel");
+    dryLevelParam = parameters.getRawParameterValue("dryLevel");
+    widthParam = parameters.getRawParameterValue("width");
+    tanGainParam = parameters.getRawParameterValue("tanGain");
+    distReturnParam = parameters.getRawParameterValue("distReturn");
+    
+    // chase synth catches trigger the delay
+    cs.onCatch = [this] (float target, int sample)
+    {
+        delay.catchTarget(target, sample);
+        eventLog.push(EventLog::targetCaught, chunkPosition + sample, target);
+    };
+    
+    // swarm catches: the first chaser drives the delay like the chase synth does, every one gets logged
+    swarm.onCatch = [this] (int chaser, float target, int sample)
+    {
+        if (chaser == 0)
+            delay.catchTarget(target, sample);
+        
+        eventLog.push(EventLog::targetCaught, chunkPosition + sample, target, (float)chaser);
+    };
+    
+    ts.setEventLog(&eventLog);
 }
 
 Drone_pieceAudioProcessor::~Drone_pieceAudioProcessor()
@@ -99,28 +136,132 @@ void Drone_pieceAudioProcessor::prepareToPlay (double sampleRate, int samplesPer
     // ---- BEGIN CUSTOM CODE ---- //
 
     
+    // hosts call this again whenever the sample rate or block size changes,
+    // the piece carries on from where it is (at the new rate) unless it's never started or the seed changed
+    double previousSR = prepared ? SR : sampleRate;
+    
     // initialize thick synth variables
     SR = sampleRate;
-    ts.setAllSampleRate(SR);
-    ts.setLFOFrequencies();
-    ts.initVector(SR);
+    eventLog.setSampleRate(SR);
+    telemetry.prepare(SR);
+    ts.setLFOFrequencies(lfoFreq1Param->load(), lfoFreq2Param->load());
+    ts.setVectorFreq(vectorFreqParam->load());
+    ts.prepare(SR, controlRate);
     
     // initialize chase synth variables
-    cs.setAllSampleRates(SR);
-    cs.setAllFrequencies();
-    cs.initVector(SR);
-    
-    // init reverb
-    juce::Reverb::Parameters reverbParams;
-    reverbParams.dryLevel = 0.5f;
-    reverbParams.wetLevel = 0.3f;
-    reverbParams.roomSize = 0.7f;
-    reverb.setParameters(reverbParams);
-    reverb.reset();
+    cs.setDistortionOversampling(distortionOversampling);
+    cs.setDistortion(tanGainParam->load(), distReturnParam->load());
+    cs.prepare(SR, controlRate);
+    
+    // or the swarm, which only allocates when the number of chasers changes
+    // new whenever it wasn't playing at this size, 16 -> 1 -> 16 starts over like 16 -> 8 does
+    bool newSwarm = numChasers > 1 && numChasers != preparedChasers;
+    preparedChasers = numChasers;
+    
+    if (preparedChasers > 1)
+    {
+        swarm.setDistortion(tanGainParam->load(), distReturnParam->load());
+        swarm.prepare(SR, controlRate, preparedChasers);
+    }
+    
+    // init panner for the output bus layout
+    panner.setChannelSet(getChannelLayoutOfBus(false, 0));
+    panner.setRampLength(controlRate);
+    samplesToPan = 0;
+    
+    // init delay, echoes sit where the chase synth's left and right extremes are
+    delay.prepare(SR, maxEchoSeconds);
+    
+    for (int side = 0; side < 2; side++)
+    {
+        echoPanners[side].setChannelSet(getChannelLayoutOfBus(false, 0));
+        echoPanners[side].setPosition(side == 0 ? 1.0f : 0.0f);
+    }
+    
+    // swarm lanes sit at fixed positions across the whole chase synth swing
+    for (int lane = 0; lane < ChaseSwarm::numLanes; lane++)
+    {
+        swarmPanners[lane].setChannelSet(getChannelLayoutOfBus(false, 0));
+        swarmPanners[lane].setPosition(ChaseSwarm::getLanePosition(lane));
+    }
+    
+    // init reverb, on every speaker (not LFE), or just W for ambisonics
+    numReverbChannels = 0;
+    for (int ch = 0; ch < panner.getNumChannels(); ch++)
+        if (panner.isSpeaker(ch) && ! (panner.isAmbisonic() && ch > 0))
+            reverbChannels[numReverbChannels++] = ch;
+    
+    reverbParams = getReverbParameters();
+    
+    for (auto& reverb : reverbs)
+    {
+        reverb.setParameters(reverbParams);
+        reverb.reset();
+    }
+    
+    // FDN reverbs only get their delay lines if they're used
+    preparedReverbLines = reverbLines;
+    
+    for (int r = 0; preparedReverbLines > 0 && r < (numReverbChannels + 1) / 2; r++)
+    {
+        fdnReverbs[r].setNumLines(preparedReverbLines);
+        fdnReverbs[r].setParameters(reverbParams);
+        fdnReverbs[r].setSampleRate(SR);
+    }
     
     // init filter
-    TS_filter.setCoefficients(juce::IIRCoefficients::makeLowPass(SR, 300.0, 1.0));
-    TS_filter.reset();
+    TS_filter.setTarget(300.0f, 1.0f);
+    TS_filter.prepare(SR, controlRate);
+    
+    // init work buffers, processBlock splits bigger blocks than this
+    scratch.setSize(numScratchChannels, juce::jmax(1, samplesPerBlock));
+    scratch.clear();
+    swarmLanes.setSize(preparedChasers > 1 ? ChaseSwarm::numLanes : 0, juce::jmax(1, samplesPerBlock));
+    
+    // seeking's control buffers, a fixed size, so only ever allocated once
+    if (seekControls.getData() == nullptr)
+        seekControls.allocate((size_t)(2 * seekChunk), true);
+    
+    // init gains, straight to the current settings
+    TS_gain.reset(SR, gainSmoothingSeconds);
+    CS_gain.reset(SR, gainSmoothingSeconds);
+    DL_gain.reset(SR, gainSmoothingSeconds);
+    TS_gain.setCurrentAndTargetValue(thickGainParam->load());
+    CS_gain.setCurrentAndTargetValue(chaseGainParam->load());
+    DL_gain.setCurrentAndTargetValue(echoGainParam->load());
+    
+    preparedBlockSize = samplesPerBlock;
+    
+    // same seed and sample rate gives the same piece
+    if (! pieceStarted)
+        startPiece();
+    else
+    {
+        samplePosition = (juce::int64)std::llround(samplePosition * (SR / previousSR));
+        
+        // a swarm that's only just been made joins the piece from its first chase
+        if (newSwarm)
+            startSwarm();
+    }
+    
+    // snapshot buffers, sized for everything above (allocated when first used)
+    SnapshotWriter counter;
+    writeSnapshot(counter);
+    snapshotSize = counter.getSize();
+    snapshots.setSlotSize(snapshotSize);
+    restoreData.free();
+    restorePending = false;
+    
+    // carry on from a saved session, exactly if it was saved from a drone prepared like this one
+    bool restored = pendingSnapshot.getSize() > 0 && readSnapshot(pendingSnapshot.getData(), pendingSnapshot.getSize());
+    
+    if (! restored && pendingState.isValid())
+        setGenerativeState(pendingState);
+    
+    pendingState = juce::ValueTree();
+    pendingSnapshot.reset();
+    
+    prepared = true;
     
     // ---- END CUSTOM CODE ---- //
     
@@ -139,21 +280,10 @@ bool Drone_pieceAudioProcessor::isBusesLayoutSupported (const BusesLayout& layou
     juce::ignoreUnused (layouts);
     return true;
 #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-        && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
-        return false;
-    
-    // This checks if the input layout matches the output layout
-#if ! JucePlugin_IsSynth
-    if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
-        return false;
-#endif
-    
-    return true;
+    // Any output layout the panner knows: mono, stereo, quad, 5.1, 7.1, 8 speaker ring, 1st / 3rd order ambisonics.
+    // The input is ignored (the drone makes all its own sound), so it doesn't have to match the output.
+    SpatialPanner::Layout layout;
+    return SpatialPanner::layoutFor(layouts.getMainOutputChannelSet(), layout);
 #endif
 }
 #endif
@@ -161,6 +291,7 @@ bool Drone_pieceAudioProcessor::isBusesLayoutSupported (const BusesLayout& layou
 void Drone_pieceAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
     juce::ScopedNoDenormals noDenormals;
+    ScopedAudioThreadCheck allocCheck; // debug builds assert if anything below allocates
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
     
@@ -176,46 +307,166 @@ void Drone_pieceAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer,
     //===================================================================
     // ---- BEGIN CUSTOM CODE ---- //
     
+    auto blockStart = profiler.now();
+    
+    // lets snapshot callers know blocks are coming
+    lastBlockTime.store(juce::jmax((juce::uint32)1, juce::Time::getMillisecondCounter()), std::memory_order_relaxed);
+    
+    // a restored session goes in before anything renders
+    if (restorePending.load(std::memory_order_acquire))
+    {
+        readSnapshot(restoreData.getData(), snapshotSize);
+        restorePending.store(false, std::memory_order_release);
+    }
+    
     // init variables
     int numSamples = buffer.getNumSamples();
-    float * leftChannel = buffer.getWritePointer(0);
-    float * rightChannel = buffer.getWritePointer(1);
 
-    // ---- START DSP LOOP ---- //
-    for (int i = 0; i < numSamples; i++)
+    float * TS_samples = scratch.getWritePointer(TS_channel);
+    float * cutoffs = scratch.getWritePointer(cutoffChannel);
+    float * resonances = scratch.getWritePointer(resChannel);
+    float * CS_samples = scratch.getWritePointer(CS_channel);
+    float * pans = scratch.getWritePointer(panChannel);
+    float * DL_left = scratch.getWritePointer(DL_leftChannel);
+    float * DL_right = scratch.getWritePointer(DL_rightChannel);
+    float * const * lanes = swarmLanes.getArrayOfWritePointers();
+    bool swarmOn = preparedChasers > 1;
+
+    // input is ignored, everything below adds into the output
+    buffer.clear();
+    
+    updateParameters();
+
+    // ---- START DSP ---- //
+    // every stage runs over a whole chunk (chunks only get split when host block is bigger than prepared)
+    for (int start = 0; start < numSamples; start += scratch.getNumSamples())
     {
-        // set up samples before processing
-        TS_raw_sample = 0.0f;
-        TS_sample = 0.0f;
-        CS_sample = 0.0f;
+        int chunk = juce::jmin(scratch.getNumSamples(), numSamples - start);
+        chunkPosition = samplePosition + start;
+        auto lapStart = profiler.now();
         
-        // process thick synth sample (pre filter)
-        TS_raw_sample = ts.process(SR);
+        // process thick synth (pre filter), along with its filter cutoff and resonance
+        ts.renderBlock(TS_samples, cutoffs, resonances, chunk);
+        lapStart = profiler.lap(StageProfiler::thickSynthStage, lapStart);
         
-        //send thick synth cutoff over to chase synth to... chase...
-        cs.setTarget(ts.getCutoff());
+        // apply filter to thick synth
+        TS_filter.processBlock(TS_samples, cutoffs, resonances, chunk);
+        lapStart = profiler.lap(StageProfiler::filterStage, lapStart);
         
-        // process chase synth sample
-        CS_sample = cs.process();
+        // process chase synth (or the swarm of them), chasing thick synth cutoff
+        if (swarmOn)
+        {
+            swarm.renderBlock(lanes, cutoffs, ts.getVectorFreq(), chunk);
+            
+            // the delay hears the whole swarm in mono, at the level the swarm plays at
+            juce::FloatVectorOperations::copy(CS_samples, lanes[0], chunk);
+            
+            for (int lane = 1; lane < ChaseSwarm::numLanes; lane++)
+                juce::FloatVectorOperations::add(CS_samples, lanes[lane], chunk);
+        }
+        else
+            cs.renderBlock(CS_samples, pans, cutoffs, chunk);
         
-        // apply gain
-        CS_sample *= CS_gain;
-
-        // apply filter to thick synth
-        TS_filter.setCoefficients(juce::IIRCoefficients::makeLowPass(SR, ts.getCutoff(), ts.getResMod()));
-        TS_sample = TS_filter.processSingleSampleRaw(TS_raw_sample);
-
-        //apply gain
-        TS_sample *= TS_gain;
+        lapStart = profiler.lap(StageProfiler::chaseSynthStage, lapStart);
+        
+        // echo the chase synth, opening up at every catch in this chunk
+        delay.process(CS_samples, DL_left, DL_right, chunk);
+        lapStart = profiler.lap(StageProfiler::delayStage, lapStart);
+        
+        // gains still gliding go on here, settled ones go on in the panners
+        float TS_level = applyGain(TS_gain, TS_samples, nullptr, chunk);
+        float CS_level = swarmOn ? applyGain(CS_gain, lanes, ChaseSwarm::numLanes, pans, chunk)
+                                 : applyGain(CS_gain, CS_samples, nullptr, chunk);
+        float DL_level = applyGain(DL_gain, DL_left, DL_right, chunk);
+        
+        // thick synth fills the room
+        panner.addOmni(TS_samples, buffer, start, chunk, TS_level);
         
-        // add samples to output channels and pan chase synth
-        leftChannel[i] = TS_sample + (CS_sample * cs.getGain1());
-        rightChannel[i] = TS_sample + (CS_sample * cs.getGain2());
+        // swarm lanes already have their chasers panned between them
+        for (int lane = 0; swarmOn && lane < ChaseSwarm::numLanes; lane++)
+            swarmPanners[lane].addPanned(lanes[lane], buffer, start, chunk, CS_level);
+        
+        // chase synth glides to each new pan position over a control period,
+        // split on control ticks (not chunks) so the output doesn't depend on block size
+        for (int done = 0; ! swarmOn && done < chunk;)
+        {
+            if (samplesToPan == 0)
+            {
+                panner.setPosition(pans[done]);
+                samplesToPan = controlRate;
+            }
+            
+            int run = juce::jmin(chunk - done, samplesToPan);
+            panner.addPanned(CS_samples + done, buffer, start + done, run, CS_level);
+            
+            done += run;
+            samplesToPan -= run;
+        }
+        
+        // echoes sit either side
+        echoPanners[0].addPanned(DL_left, buffer, start, chunk, DL_level);
+        echoPanners[1].addPanned(DL_right, buffer, start, chunk, DL_level);
+        profiler.lap(StageProfiler::mixStage, lapStart);
     }
-    // ---- END DSP LOOP ---- //
+    // ---- END DSP ---- //
     
-    // apply reverb
-    reverb.processStereo(leftChannel, rightChannel, numSamples);
+    // apply reverb, speakers in pairs, odd one out in mono
+    auto reverbStart = profiler.now();
+    int reverbed = 0;
+    for (int r = 0; reverbed < numReverbChannels; r++)
+    {
+        if (numReverbChannels - reverbed >= 2)
+        {
+            float * left = buffer.getWritePointer(reverbChannels[reverbed]);
+            float * right = buffer.getWritePointer(reverbChannels[reverbed + 1]);
+            
+            if (preparedReverbLines > 0)
+                fdnReverbs[r].processStereo(left, right, numSamples);
+            else
+                reverbs[r].processStereo(left, right, numSamples);
+            
+            reverbed += 2;
+        }
+        else
+        {
+            float * mono = buffer.getWritePointer(reverbChannels[reverbed]);
+            
+            if (preparedReverbLines > 0)
+                fdnReverbs[r].processMono(mono, numSamples);
+            else
+                reverbs[r].processMono(mono, numSamples);
+            
+            reverbed += 1;
+        }
+    }
+    
+    profiler.lap(StageProfiler::reverbStage, reverbStart);
+    
+    samplePosition += numSamples;
+    
+    // scope, spectrum and state for the editor, a single atomic load while it's closed
+    if (telemetry.isActive())
+    {
+        bool stereo = buffer.getNumChannels() > 1 && ! panner.isAmbisonic(); // W on its own for ambisonics
+        telemetry.pushSamples(buffer.getReadPointer(0), stereo ? buffer.getReadPointer(1) : nullptr, numSamples);
+        
+        if (telemetry.stateDue(numSamples))
+        {
+            Telemetry::State state;
+            fillTelemetryState(state);
+            telemetry.pushState(state);
+        }
+    }
+    
+    // someone's waiting on a snapshot, hand over the state this block left behind
+    if (snapshots.isRequested())
+    {
+        auto writer = snapshots.startWriting();
+        writeSnapshot(writer);
+        snapshots.finishWriting(writer);
+    }
+    
+    profiler.endBlock(blockStart);
     
     // ---- END CUSTOM CODE ---- //
 }
@@ -235,17 +486,574 @@ juce::AudioProcessorEditor* Drone_pieceAudioProcessor::createEditor()
 }
 
 //==============================================================================
+// parameters, the seed, and the generative state (how far the piece has grown), so a session reloads where it was
+// an exact snapshot goes after the XML, the generative state in the XML is the fallback for a drone prepared differently
 void Drone_pieceAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
+    auto state = parameters.copyState();
+    state.setProperty("seed", getSeed(), nullptr);
+    state.removeChild(state.getChildWithName("generative"), nullptr);
+    
+    {
+        // synths only change inside processBlock, which runs under the callback lock
+        const juce::ScopedLock sl (getCallbackLock());
+        auto generative = prepared ? getGenerativeState() : pendingState.createCopy();
+        
+        if (generative.isValid())
+            state.appendChild(generative, nullptr);
+    }
+    
+    juce::MemoryBlock snapshot;
+    
+    if (! (prepared && getSnapshot(snapshot)))
+        snapshot = pendingSnapshot;
+    
+    std::unique_ptr<juce::XmlElement> xml (state.createXml());
+    juce::MemoryBlock xmlData;
+    copyXmlToBinary(*xml, xmlData);
+    
+    juce::MemoryOutputStream out (destData, false);
+    out.writeInt(stateMagic);
+    out.writeInt((int)xmlData.getSize());
+    out << xmlData;
+    out << snapshot;
 }
 
 void Drone_pieceAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
+    // sessions saved before snapshots are just the XML
+    juce::MemoryBlock xmlData (data, (size_t)sizeInBytes);
+    juce::MemoryBlock snapshot;
+    
+    if (sizeInBytes >= 8 && juce::ByteOrder::littleEndianInt(data) == (juce::uint32)stateMagic)
+    {
+        auto xmlSize = (size_t)juce::jlimit(0, sizeInBytes - 8, (int)juce::ByteOrder::littleEndianInt(static_cast<const char*>(data) + 4));
+        xmlData.replaceWith(static_cast<const char*>(data) + 8, xmlSize);
+        snapshot.replaceWith(static_cast<const char*>(data) + 8 + xmlSize, (size_t)sizeInBytes - 8 - xmlSize);
+    }
+    
+    std::unique_ptr<juce::XmlElement> xml (getXmlFromBinary(xmlData.getData(), (int)xmlData.getSize()));
+    
+    if (xml == nullptr || ! xml->hasTagName(parameters.state.getType()))
+        return;
+    
+    auto state = juce::ValueTree::fromXml(*xml);
+    auto generative = state.getChildWithName("generative");
+    state.removeChild(generative, nullptr);
+    
+    // the seed only matters for things the generative state doesn't cover, and a fresh prepareToPlay
+    setSeed((juce::int64)state.getProperty("seed", getSeed()));
+    parameters.replaceState(state);
+    
+    // exactly where it was, if this drone is prepared the same way
+    if (prepared && snapshot.getSize() > 0 && setSnapshot(snapshot.getData(), snapshot.getSize()))
+        return;
+    
+    const juce::ScopedLock sl (getCallbackLock());
+    
+    if (prepared && generative.isValid())
+        setGenerativeState(generative);
+    else if (! prepared)
+    {
+        pendingState = generative;
+        pendingSnapshot = snapshot;
+    }
+}
+
+//==============================================================================
+bool Drone_pieceAudioProcessor::getSnapshot (juce::MemoryBlock& destData)
+{
+    if (! prepared)
+        return false;
+    
+    // playing: the audio thread writes it at the end of its next block
+    if (! isNonRealtime() && isAudioRunning() && snapshots.takeSnapshot(destData, snapshotTimeoutMs))
+        return true;
+    
+    // stopped (or rendering offline, between blocks): nothing else is touching the state, write it straight out
+    const juce::ScopedLock sl (getCallbackLock());
+    destData.setSize(snapshotSize);
+    SnapshotWriter writer (destData.getData(), destData.getSize());
+    writeSnapshot(writer);
+    return ! writer.failed();
+}
+
+bool Drone_pieceAudioProcessor::setSnapshot (const void* data, size_t sizeInBytes)
+{
+    if (! prepared)
+    {
+        pendingSnapshot.replaceWith(data, sizeInBytes);
+        return true;
+    }
+    
+    // checked here, so a snapshot that doesn't fit is caught before it gets to the audio thread
+    SnapshotReader header (data, sizeInBytes);
+    
+    if (! readSnapshotHeader(header, sizeInBytes))
+        return false;
+    
+    const juce::ScopedLock rl (restoreLock);
+    
+    // playing: hand it to the audio thread, which reads it in at the start of its next block
+    if (! isNonRealtime() && isAudioRunning())
+    {
+        auto start = juce::Time::getMillisecondCounter();
+        
+        // last one still waiting to go in
+        while (restorePending.load(std::memory_order_acquire) && juce::Time::getMillisecondCounter() - start < (juce::uint32)snapshotTimeoutMs)
+            juce::Thread::sleep(1);
+        
+        if (! restorePending.load(std::memory_order_acquire))
+        {
+            if (restoreData.getData() == nullptr)
+                restoreData.allocate(snapshotSize, false);
+            
+            std::memcpy(restoreData.getData(), data, sizeInBytes);
+            restorePending.store(true, std::memory_order_release);
+            return true;
+        }
+    }
+    
+    // stopped: straight in, and nothing older left waiting for the audio thread
+    const juce::ScopedLock sl (getCallbackLock());
+    restorePending.store(false, std::memory_order_release);
+    return readSnapshot(data, sizeInBytes);
+}
+
+bool Drone_pieceAudioProcessor::isAudioRunning()
+{
+    auto last = lastBlockTime.load(std::memory_order_relaxed);
+    return last != 0 && juce::Time::getMillisecondCounter() - last < (juce::uint32)snapshotTimeoutMs;
+}
+
+juce::ValueTree Drone_pieceAudioProcessor::getGenerativeState()
+{
+    juce::ValueTree state ("generative");
+    state.appendChild(ts.getState(), nullptr);
+    state.appendChild(cs.getState(), nullptr);
+    return state;
+}
+
+void Drone_pieceAudioProcessor::setGenerativeState (const juce::ValueTree& state)
+{
+    ts.setState(state.getChildWithName("thickSynth"));
+    cs.setState(state.getChildWithName("chasingSynth"));
+    samplesToPan = 0; // both synths start a fresh control period
+    
+    // the swarm isn't saved, it starts over
+    if (preparedChasers > 1)
+        startSwarm();
+    
+    pieceStarted = true; // the restored piece, not a new one
+}
+
+// header (what the drone was prepared with), then every stage in processBlock order
+// juce::Reverb keeps its tail to itself, so with it the reverb starts empty, FdnReverb tails are saved
+void Drone_pieceAudioProcessor::writeSnapshot (SnapshotWriter& writer)
+{
+    writer.write(snapshotMagic);
+    writer.write(snapshotVersion);
+    writer.write((juce::uint64)snapshotSize);
+    writer.write(SR);
+    writer.write(controlRate);
+    writer.write((int)panner.getLayout());
+    writer.write(preparedReverbLines);
+    writer.write(distortionOversampling);
+    writer.write(preparedChasers);
+    writer.write(samplePosition);
+    
+    ts.writeSnapshot(writer);
+    TS_filter.writeSnapshot(writer);
+    cs.writeSnapshot(writer);
+    
+    if (preparedChasers > 1)
+        swarm.writeSnapshot(writer);
+    
+    delay.writeSnapshot(writer);
+    
+    panner.writeSnapshot(writer);
+    echoPanners[0].writeSnapshot(writer);
+    echoPanners[1].writeSnapshot(writer);
+    
+    for (int lane = 0; preparedChasers > 1 && lane < ChaseSwarm::numLanes; lane++)
+        swarmPanners[lane].writeSnapshot(writer);
+    
+    writer.write(samplesToPan);
+    
+    writer.writeSmoothed(TS_gain);
+    writer.writeSmoothed(CS_gain);
+    writer.writeSmoothed(DL_gain);
+    
+    for (int r = 0; preparedReverbLines > 0 && r < (numReverbChannels + 1) / 2; r++)
+        fdnReverbs[r].writeSnapshot(writer);
+}
+
+bool Drone_pieceAudioProcessor::readSnapshot (const void* data, size_t sizeInBytes)
+{
+    SnapshotReader reader (data, sizeInBytes);
+    
+    if (! readSnapshotHeader(reader, sizeInBytes))
+        return false;
+    
+    reader.read(samplePosition);
+    ts.readSnapshot(reader);
+    TS_filter.readSnapshot(reader);
+    cs.readSnapshot(reader);
+    
+    if (preparedChasers > 1)
+        swarm.readSnapshot(reader);
+    
+    delay.readSnapshot(reader);
+    
+    panner.readSnapshot(reader);
+    echoPanners[0].readSnapshot(reader);
+    echoPanners[1].readSnapshot(reader);
+    
+    for (int lane = 0; preparedChasers > 1 && lane < ChaseSwarm::numLanes; lane++)
+        swarmPanners[lane].readSnapshot(reader);
+    
+    reader.read(samplesToPan);
+    
+    reader.readSmoothed(TS_gain);
+    reader.readSmoothed(CS_gain);
+    reader.readSmoothed(DL_gain);
+    
+    for (int r = 0; preparedReverbLines > 0 && r < (numReverbChannels + 1) / 2; r++)
+        fdnReverbs[r].readSnapshot(reader);
+    
+    if (preparedReverbLines == 0)
+        for (auto& reverb : reverbs)
+            reverb.reset();
+    
+    pieceStarted = true; // the restored piece, not a new one
+    
+    jassert(! reader.failed()); // header matched, so the sizes have to
+    return ! reader.failed();
+}
+
+// sizes aren't stored, so everything that decides them has to match
+bool Drone_pieceAudioProcessor::readSnapshotHeader (SnapshotReader& reader, size_t sizeInBytes)
+{
+    juce::uint32 magic = 0, version = 0;
+    juce::uint64 size = 0;
+    float sampleRate = 0.0f;
+    int rate = 0, layout = -1, lines = -1, oversampling = 0, chasers = 0;
+    
+    reader.read(magic);
+    reader.read(version);
+    reader.read(size);
+    reader.read(sampleRate);
+    reader.read(rate);
+    reader.read(layout);
+    reader.read(lines);
+    reader.read(oversampling);
+    reader.read(chasers);
+    
+    return ! reader.failed()
+        && magic == snapshotMagic
+        && version == snapshotVersion
+        && size == snapshotSize && sizeInBytes == snapshotSize
+        && sampleRate == SR
+        && rate == controlRate
+        && layout == (int)panner.getLayout()
+        && lines == preparedReverbLines
+        && oversampling == distortionOversampling
+        && chasers == preparedChasers;
+}
+
+//==============================================================================
+// the seed isn't one of these: a 64 bit seed doesn't survive a host's normalised float,
+// and automating it would restart the piece mid block, it goes through setSeed() and the saved state instead
+juce::AudioProcessorValueTreeState::ParameterLayout Drone_pieceAudioProcessor::createParameterLayout()
+{
+    juce::AudioProcessorValueTreeState::ParameterLayout layout;
+    
+    // slow things want most of the knob near the bottom
+    juce::NormalisableRange<float> lfo1Range (0.001f, 1.0f);
+    lfo1Range.setSkewForCentre(0.06f);
+    juce::NormalisableRange<float> lfo2Range (0.0005f, 0.1f);
+    lfo2Range.setSkewForCentre(0.005f);
+    
+    // mix
+    layout.add(std::make_unique<juce::AudioParameterFloat>("thickGain", "Thick Synth Gain", juce::NormalisableRange<float> (0.0f, 1.0f), 0.6f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("chaseGain", "Chase Synth Gain", juce::NormalisableRange<float> (0.0f, 0.5f), 0.09f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("echoGain", "Echo Gain", juce::NormalisableRange<float> (0.0f, 0.5f), 0.06f));
+    
+    // thick synth
+    layout.add(std::make_unique<juce::AudioParameterFloat>("vectorFreq", "Drone Frequency", juce::NormalisableRange<float> (20.0f, 120.0f), 45.0f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("lfoFreq1", "Filter LFO Rate", lfo1Range, 0.0612f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("lfoFreq2", "Resonance LFO Rate", lfo2Range, 0.005f));
+    
+    // reverb, same defaults as before there were knobs
+    layout.add(std::make_unique<juce::AudioParameterFloat>("roomSize", "Reverb Size", juce::NormalisableRange<float> (0.0f, 1.0f), 0.7f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("damping", "Reverb Damping", juce::NormalisableRange<float> (0.0f, 1.0f), 0.5f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("wetLevel", "Reverb Wet", juce::NormalisableRange<float> (0.0f, 1.0f), 0.3f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("dryLevel", "Reverb Dry", juce::NormalisableRange<float> (0.0f, 1.0f), 0.5f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("width", "Reverb Width", juce::NormalisableRange<float> (0.0f, 1.0f), 1.0f));
+    
+    // chase synth distortion
+    layout.add(std::make_unique<juce::AudioParameterFloat>("tanGain", "Distortion Drive", juce::NormalisableRange<float> (0.5f, 8.0f), 2.0f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("distReturn", "Distortion Clip", juce::NormalisableRange<float> (0.0f, 1.0f), 0.8f));
+    
+    return layout;
+}
+
+// latest parameter values into everything that uses them, only atomic loads, no locks
+void Drone_pieceAudioProcessor::updateParameters()
+{
+    TS_gain.setTargetValue(thickGainParam->load());
+    CS_gain.setTargetValue(chaseGainParam->load());
+    DL_gain.setTargetValue(echoGainParam->load());
+    
+    // these glide inside the synths, a control tick or a distortion block at a time
+    ts.setVectorFreq(vectorFreqParam->load());
+    ts.setLFOFrequencies(lfoFreq1Param->load(), lfoFreq2Param->load());
+    cs.setDistortion(tanGainParam->load(), distReturnParam->load());
+    swarm.setDistortion(tanGainParam->load(), distReturnParam->load());
+    
+    // reverbs glide on their own, only tell them when something moved
+    auto newParams = getReverbParameters();
+    
+    if (newParams.roomSize != reverbParams.roomSize || newParams.damping != reverbParams.damping
+        || newParams.wetLevel != reverbParams.wetLevel || newParams.dryLevel != reverbParams.dryLevel
+        || newParams.width != reverbParams.width)
+    {
+        reverbParams = newParams;
+        
+        for (int r = 0; r < (numReverbChannels + 1) / 2; r++)
+        {
+            if (preparedReverbLines > 0)
+                fdnReverbs[r].setParameters(reverbParams);
+            else
+                reverbs[r].setParameters(reverbParams);
+        }
+    }
+}
+
+juce::Reverb::Parameters Drone_pieceAudioProcessor::getReverbParameters()
+{
+    juce::Reverb::Parameters params;
+    params.roomSize = roomSizeParam->load();
+    params.damping = dampingParam->load();
+    params.wetLevel = wetLevelParam->load();
+    params.dryLevel = dryLevelParam->load();
+    params.width = widthParam->load();
+    return params;
+}
+
+// gain still gliding: applied to samples (and moreSamples) here, returns 1
+// gain settled: returns it, for the panners to apply for free
+float Drone_pieceAudioProcessor::applyGain (juce::SmoothedValue<float>& gain, float* samples, float* moreSamples, int numSamples)
+{
+    if (! gain.isSmoothing())
+        return gain.getTargetValue();
+    
+    for (int i = 0; i < numSamples; i++)
+    {
+        float g = gain.getNextValue();
+        samples[i] *= g;
+        
+        if (moreSamples != nullptr)
+            moreSamples[i] *= g;
+    }
+    
+    return 1.0f;
+}
+
+// applyGain for any number of channels, the glide goes into gains first (numSamples floats of scratch)
+float Drone_pieceAudioProcessor::applyGain (juce::SmoothedValue<float>& gain, float* const* channels, int numChannels, float* gains, int numSamples)
+{
+    if (! gain.isSmoothing())
+        return gain.getTargetValue();
+    
+    for (int i = 0; i < numSamples; i++)
+        gains[i] = gain.getNextValue();
+    
+    for (int ch = 0; ch < numChannels; ch++)
+        juce::FloatVectorOperations::multiply(channels[ch], gains, numSamples);
+    
+    return 1.0f;
+}
+
+//==============================================================================
+// straight to any point in the piece, forwards at control rate (see skipSamples), backwards by starting over
+void Drone_pieceAudioProcessor::seekTo (double seconds)
+{
+    if (! prepared)
+        return;
+    
+    // a host is playing, seek while stopped (see seekTo in the header)
+    jassert(isNonRealtime() || ! isAudioRunning());
+    
+    const juce::ScopedLock sl (getCallbackLock());
+    auto target = juce::jmax((juce::int64)0, (juce::int64)std::llround(seconds * SR));
+    
+    if (target < samplePosition)
+        startPiece();
+    
+    skipSamples(target - samplePosition);
+}
+
+double Drone_pieceAudioProcessor::getPosition()
+{
+    return samplePosition / (double)SR;
+}
+
+// processBlock without the audio: both synths run their control ticks and events exactly as they would,
+// chunks of cutoffs pass from one to the other like they do in processBlock
+// oscillators jump ahead at their average frequency, everything that only holds audio (filter, echoes, reverb) starts empty
+void Drone_pieceAudioProcessor::skipSamples (juce::int64 numSamples)
+{
+    if (numSamples <= 0)
+        return;
+    
+    float* cutoffs = seekControls.getData();
+    float* resonances = cutoffs + seekChunk;
+    
+    for (juce::int64 done = 0; done < numSamples;)
+    {
+        int chunk = (int)juce::jmin((juce::int64)seekChunk, numSamples - done);
+        
+        ts.skipBlock(cutoffs, resonances, chunk);
+        
+        if (preparedChasers > 1)
+            swarm.skipBlock(cutoffs, ts.getVectorFreq(), chunk);
+        else
+            cs.skipBlock(cutoffs, chunk);
+        
+        done += chunk;
+    }
+    
+    // filter carries on from the last cutoff, with an empty memory
+    TS_filter.setTarget(ts.getCutoff(), ts.getResMod());
+    TS_filter.reset();
+    
+    delay.reset();
+    
+    for (auto& reverb : reverbs)
+        reverb.reset();
+    
+    for (int r = 0; preparedReverbLines > 0 && r < (numReverbChannels + 1) / 2; r++)
+        fdnReverbs[r].reset();
+    
+    // gains at their settings, the chase synth's pan ticks still in step with its control ticks
+    TS_gain.setCurrentAndTargetValue(TS_gain.getTargetValue());
+    CS_gain.setCurrentAndTargetValue(CS_gain.getTargetValue());
+    DL_gain.setCurrentAndTargetValue(DL_gain.getTargetValue());
+    samplesToPan = (int)(((samplesToPan - numSamples) % controlRate + controlRate) % controlRate);
+    
+    samplePosition += numSamples;
+}
+
+// back to the very beginning of the piece: both synths seeded and at their first notes, nothing left ringing
+// never allocates, the synths and effects have to be prepared already
+void Drone_pieceAudioProcessor::startPiece()
+{
+    ts.setSeed(randomSource.getStreamSeed(RandomSource::thickSynthStream));
+    ts.setNoiseSeed(randomSource.getStreamSeed(RandomSource::thickSynthNoiseStream));
+    cs.setSeed(randomSource.getStreamSeed(RandomSource::chasingSynthStream));
+    ts.reset();
+    cs.reset();
+    
+    if (preparedChasers > 1)
+        startSwarm();
+    
+    TS_filter.setTarget(300.0f, 1.0f);
+    TS_filter.reset();
+    delay.reset();
+    
+    for (auto& reverb : reverbs)
+        reverb.reset();
+    
+    for (int r = 0; preparedReverbLines > 0 && r < (numReverbChannels + 1) / 2; r++)
+        fdnReverbs[r].reset();
+    
+    samplesToPan = 0;
+    samplePosition = 0;
+    pieceStarted = true;
+}
+
+// chaser seeds have their own stream, so the swarm never shifts the chase synth's numbers
+void Drone_pieceAudioProcessor::startSwarm()
+{
+    swarm.setSeed(randomSource.getStreamSeed(RandomSource::chaseSwarmStream));
+    swarm.reset();
+}
+
+//==============================================================================
+StageProfiler::Stats Drone_pieceAudioProcessor::getStageStats (int stage)
+{
+    return profiler.getStats(stage);
+}
+
+void Drone_pieceAudioProcessor::resetProfiler()
+{
+    profiler.reset();
+}
+
+//==============================================================================
+Telemetry& Drone_pieceAudioProcessor::getTelemetry()
+{
+    return telemetry;
+}
+
+// where both synths are at the end of this block, only reads plain members, no allocation
+void Drone_pieceAudioProcessor::fillTelemetryState (Telemetry::State& state)
+{
+    state.time = samplePosition;
+    state.oscCount = juce::jmin(ts.getOscCount(), Telemetry::maxVoices);
+    state.vectorFreq = ts.getVectorFreq();
+    state.cutoff = ts.getCutoff();
+    state.resonance = ts.getResMod();
+    
+    // the swarm's first chaser stands in for the chase synth
+    bool swarmOn = preparedChasers > 1;
+    state.chaseFreq = swarmOn ? swarm.getFrequency(0) : cs.getFrequency();
+    state.chaseTarget = swarmOn ? swarm.getTarget(0) : cs.getTarget();
+    state.chasePan = swarmOn ? swarm.getPanPosition(0) : cs.getPanPosition();
+    
+    for (int i = 0; i < state.oscCount; i++)
+        state.gainLFOFreqs[i] = ts.getGainLFOFreq(i);
+}
+
+//==============================================================================
+bool Drone_pieceAudioProcessor::startEventLog (const juce::File& file)
+{
+    return eventLog.start(file);
+}
+
+void Drone_pieceAudioProcessor::stopEventLog()
+{
+    eventLog.stop();
+}
+
+//==============================================================================
+void Drone_pieceAudioProcessor::setSeed (juce::int64 seed)
+{
+    if (seed != randomSource.getSeed())
+        pieceStarted = false;
+    
+    randomSource.setSeed(seed);
+}
+
+juce::int64 Drone_pieceAudioProcessor::getSeed()
+{
+    return randomSource.getSeed();
+}
+
+void Drone_pieceAudioProcessor::setDistortionOversampling (int factor)
+{
+    distortionOversampling = factor;
+}
+
+void Drone_pieceAudioProcessor::setReverbEngine (int lines)
+{
+    reverbLines = lines <= 0 ? 0 : (lines >= 16 ? 16 : (lines >= 8 ? 8 : 4)); // what FdnReverb can do
+}
+
+void Drone_pieceAudioProcessor::setChasers (int count)
+{
+    numChasers = juce::jlimit(1, ChaseSwarm::maxChasers, count);
 }
 
 //==============================================================================
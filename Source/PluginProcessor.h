@@ -12,7 +12,17 @@
 #include "osc.h"
 #include "thickSynth.h"
 #include "chasingSynth.h"
+#include "chaseSwarm.h"
 #include "effects.h"
+#include "modFilter.h"
+#include "audioThreadCheck.h"
+#include "randomSource.h"
+#include "spatialPanner.h"
+#include "fdnReverb.h"
+#include "snapshot.h"
+#include "eventLog.h"
+#include "stageProfiler.h"
+#include "telemetry.h"
 
 //==============================================================================
 /**
@@ -56,26 +66,171 @@ public:
     //==============================================================================
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
+    
+    //==============================================================================
+    // piece seed, a new one starts the piece over at the next prepareToPlay
+    // saved with the session, not a host parameter (see createParameterLayout)
+    void setSeed (juce::int64 seed);
+    juce::int64 getSeed();
+    
+    // chase synth distortion oversampling, 1 (live) 2 or 4 (quality renders), takes effect at the next prepareToPlay
+    void setDistortionOversampling (int factor);
+    
+    // 0 = juce::Reverb (Freeverb), 4, 8 or 16 = FdnReverb with that many lines, much cheaper
+    // anything else goes to the nearest of those, takes effect at the next prepareToPlay
+    void setReverbEngine (int lines);
+    
+    // 1 = the chase synth on its own, 2 - ChaseSwarm::maxChasers = a swarm of them (chaser 0 is the chase synth's chase)
+    // takes effect at the next prepareToPlay
+    void setChasers (int count);
+    
+    // exact binary snapshot of the piece as it is right now, see snapshot.h
+    // safe from any thread but the audio thread, cheap enough to take every few seconds from a background thread:
+    // the audio thread only copies its state out at the end of a block, it never waits or locks
+    bool getSnapshot (juce::MemoryBlock& destData);
+    
+    // carries on exactly from a getSnapshot(), false if it came from a drone prepared differently
+    // (sample rate, control rate, output layout, reverb engine, oversampling, chasers)
+    // before prepareToPlay it's kept and tried then
+    bool setSnapshot (const void* data, size_t sizeInBytes);
+    
+    // jumps to seconds into the piece without rendering it (an hour takes a fraction of a second)
+    // every partial change, random number, LFO and chase lands where playing would have put it,
+    // oscillator phases are approximate and the filter, echoes and reverb start empty
+    // earlier than now starts the piece over first
+    // only while stopped (or offline, from the thread calling processBlock): a long seek holds the callback lock
+    // for as long as it takes, asserts if processBlock ran in the last moment
+    void seekTo (double seconds);
+    double getPosition(); // seconds since prepareToPlay (or since the start of a restored session)
+    
+    // traces catches, gain LFO changes and partial count changes to file (or stdout for juce::File()), see eventLog.h
+    // written from the audio thread without locking or I/O, formatted on a background thread
+    bool startEventLog (const juce::File& file);
+    void stopEventLog();
+    
+    // processBlock time per stage (StageProfiler::Stage), microseconds per block since the last reset, from any thread
+    // all zeros when built with DRONE_PROFILING 0
+    StageProfiler::Stats getStageStats (int stage);
+    void resetProfiler(); // takes effect at the end of the next block
+    
+    // output samples and generative state for the editor's scope, spectrum and state view, see telemetry.h
+    // nothing is sent until the editor calls setActive(true)
+    Telemetry& getTelemetry();
+    
+    // host automatable parameters (gains, pitch, LFO rates, reverb, distortion), see createParameterLayout()
+    juce::AudioProcessorValueTreeState parameters;
 
 private:
     
+    // ---- parameters ---- //
+    static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
+    void updateParameters(); // once per block, audio thread
+    juce::Reverb::Parameters getReverbParameters();
+    static float applyGain (juce::SmoothedValue<float>& gain, float* samples, float* moreSamples, int numSamples);
+    static float applyGain (juce::SmoothedValue<float>& gain, float* const* channels, int numChannels, float* gains, int numSamples);
+    
+    // generative state, see getStateInformation
+    juce::ValueTree getGenerativeState();
+    void setGenerativeState (const juce::ValueTree& state);
+    
+    // exact state, see getSnapshot
+    void writeSnapshot (SnapshotWriter& writer);
+    bool readSnapshot (const void* data, size_t sizeInBytes); // false (nothing changed) if it doesn't fit this drone
+    bool readSnapshotHeader (SnapshotReader& reader, size_t sizeInBytes); // true if it came from a drone prepared like this one
+    bool isAudioRunning(); // processBlock ran recently, so it'll pick up snapshot requests
+    
+    // seeking, see seekTo
+    void skipSamples (juce::int64 numSamples);
+    void startPiece(); // seeds everything and starts from the top, see prepareToPlay
+    void startSwarm(); // seeds the swarm and starts every chaser from the top
+    
+    // parameter values, written by the host, read once per block without locking
+    std::atomic<float>* thickGainParam = nullptr;
+    std::atomic<float>* chaseGainParam = nullptr;
+    std::atomic<float>* echoGainParam = nullptr;
+    std::atomic<float>* vectorFreqParam = nullptr;
+    std::atomic<float>* lfoFreq1Param = nullptr;
+    std::atomic<float>* lfoFreq2Param = nullptr;
+    std::atomic<float>* roomSizeParam = nullptr;
+    std::atomic<float>* dampingParam = nullptr;
+    std::atomic<float>* wetLevelParam = nullptr;
+    std::atomic<float>* dryLevelParam = nullptr;
+    std::atomic<float>* widthParam = nullptr;
+    std::atomic<float>* tanGainParam = nullptr;
+    std::atomic<float>* distReturnParam = nullptr;
+    
+    bool prepared = false; // synths are set up, generative state can go straight in
+    std::atomic<bool> pieceStarted { false }; // false until the first prepareToPlay, and after a new seed (set by the audio thread when it restores a snapshot)
+    juce::ValueTree pendingState; // generative state loaded before prepareToPlay
+    
+    // ---- snapshots ---- //
+    static constexpr juce::uint32 snapshotMagic = 0x4e535244; // "DRSN"
+    static constexpr juce::uint32 snapshotVersion = 5; // bump whenever anything's writeSnapshot() changes
+    static constexpr int stateMagic = 0x31535244; // "DRS1", getStateInformation with a snapshot after the XML
+    static constexpr int snapshotTimeoutMs = 200; // longest getSnapshot() waits for the audio thread
+
+    SnapshotBuffer snapshots; // double buffered, filled at the end of a block when asked for
+    size_t snapshotSize = 0; // bytes in a snapshot of this drone as prepared
+    juce::HeapBlock<char> restoreData; // snapshot going in at the start of the next block
+    std::atomic<bool> restorePending { false };
+    juce::CriticalSection restoreLock; // one setSnapshot() at a time, never taken by the audio thread
+    juce::MemoryBlock pendingSnapshot; // snapshot loaded before prepareToPlay
+    std::atomic<juce::uint32> lastBlockTime { 0 }; // millisecond counter at the last processBlock
+    
+    EventLog eventLog; // off until startEventLog()
+    StageProfiler profiler; // processBlock stage timings, see getStageStats
+    Telemetry telemetry; // editor's view of the output and the synths, off while it's closed
+    void fillTelemetryState (Telemetry::State& state); // audio thread
+
     // ---- initialize class variables ---- //
     ThickSynth ts;
     ChasingSynth cs;
+    ChaseSwarm swarm; // only prepared (and rendered instead of cs) with more than one chaser
     
     // ---- initialize process variables ---- //
     float SR; // sample rate
-    float TS_raw_sample; // thick synth pre-filter sample
-    float TS_sample; // thick synth post-filter sample
-    float CS_sample; // chase synth sample
-    float TS_gain = 0.6; // thick synth gain
-    float CS_gain = 0.09; // chase synth gain
+    int preparedBlockSize = 0; // samplesPerBlock at the last prepareToPlay
+    juce::int64 samplePosition = 0; // samples into the piece
+    juce::int64 chunkPosition = 0; // samples into the piece at the start of the chunk being rendered
+    static constexpr int seekChunk = 4096; // samples per skipBlock() while seeking
+    juce::HeapBlock<float> seekControls; // cutoffs and resonances for skipBlock(), 2 * seekChunk, allocated in prepareToPlay
+    int controlRate = 32; // samples between LFO, chase and filter coefficient updates
+    juce::SmoothedValue<float> TS_gain; // thick synth gain
+    juce::SmoothedValue<float> CS_gain; // chase synth gain
+    juce::SmoothedValue<float> DL_gain; // catch delay echoes gain
+    double gainSmoothingSeconds = 0.05;
+    double maxEchoSeconds = 4.0; // longest catch delay, sets the ring buffer size
+    int distortionOversampling = 1; // chase synth distortion, 1 = ADAA only
+    int numChasers = 1; // 1 = cs, more = swarm, see setChasers
+    int preparedChasers = 1; // numChasers at the last prepareToPlay
+    
+    RandomSource randomSource; // one seed, separate streams for each synth
+    
+    ModFilter TS_filter; // thick synth filter, coefficients updated at control rate
+    
+    // per stage work buffers, sized in prepareToPlay
+    // thick synth, filter cutoffs, filter resonances, chase synth (mono, panned into the output), chase synth pan positions,
+    // delay left, delay right
+    enum ScratchChannels { TS_channel = 0, cutoffChannel, resChannel, CS_channel, panChannel, DL_leftChannel, DL_rightChannel, numScratchChannels };
+    juce::AudioBuffer<float> scratch;
+    
+    SpatialPanner panner; // places the chase synth in whatever layout the output bus is
+    int samplesToPan = 0; // countdown to the next pan move, in step with the chase synth's control ticks
     
-    juce::Random random;
+    CatchDelay delay; // echoes the chase synth each time it catches its target
+    SpatialPanner echoPanners[2]; // delay's left and right, fixed either side
     
-    juce::IIRFilter TS_filter;
+    juce::AudioBuffer<float> swarmLanes; // swarm output, ChaseSwarm::numLanes channels, sized in prepareToPlay
+    SpatialPanner swarmPanners[ChaseSwarm::numLanes]; // one per lane, fixed at the lane's position
     
-    juce::Reverb reverb;
+    // one reverb per pair of speakers (ambisonics only reverbs W), channels listed in prepareToPlay
+    juce::Reverb reverbs[SpatialPanner::maxChannels / 2];
+    FdnReverb fdnReverbs[SpatialPanner::maxChannels / 2];
+    int reverbLines = 0; // 0 = juce::Reverb, otherwise FDN lines, see setReverbEngine
+    int preparedReverbLines = 0; // reverbLines at the last prepareToPlay, the only one processBlock and snapshots look at
+    juce::Reverb::Parameters reverbParams; // what the reverbs were last given
+    int reverbChannels[SpatialPanner::maxChannels];
+    int numReverbChannels = 0;
     
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Drone_pieceAudioProcessor)
@@ -0,0 +1,111 @@
+/*
+  ==============================================================================
+
+    allocationCounter.h
+    Created: 18 Oct 2026 10:12:40am
+    Author:  Christopher Duvall
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cerrno>
+#include "audioThreadCheck.h"
+
+/**
+ Counting allocator behind ScopedAudioThreadCheck, for the drone's own console executables only.
+ Include it in exactly one .cpp of an executable, never in the plugin:
+ it replaces the process's allocator, which a plugin has no business doing inside somebody else's host.
+
+ Linux (glibc): malloc, calloc, realloc and the aligned versions are wrapped, so everything is counted,
+ juce::HeapBlock, AudioBuffer::setSize and MemoryBlock as well as operator new (which goes through malloc).
+ Elsewhere only the global operator new is replaced, so malloc based allocations aren't counted.
+
+ Compiles to nothing with DRONE_CHECK_AUDIO_ALLOCATIONS 0 (release builds by default).
+*/
+
+#if DRONE_CHECK_AUDIO_ALLOCATIONS
+
+#if defined (__GLIBC__)
+
+extern "C"
+{
+    // glibc's own allocator, under the names it exports for exactly this
+    void* __libc_malloc (size_t size);
+    void* __libc_calloc (size_t count, size_t size);
+    void* __libc_realloc (void* ptr, size_t size);
+    void* __libc_memalign (size_t alignment, size_t size);
+
+    void* malloc (size_t size)
+    {
+        ScopedAudioThreadCheck::countAllocation();
+        return __libc_malloc(size);
+    }
+
+    void* calloc (size_t count, size_t size)
+    {
+        ScopedAudioThreadCheck::countAllocation();
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc (void* ptr, size_t size)
+    {
+        ScopedAudioThreadCheck::countAllocation();
+        return __libc_realloc(ptr, size);
+    }
+
+    void* aligned_alloc (size_t alignment, size_t size)
+    {
+        ScopedAudioThreadCheck::countAllocation();
+        return __libc_memalign(alignment, size);
+    }
+
+    int posix_memalign (void** ptr, size_t alignment, size_t size)
+    {
+        ScopedAudioThreadCheck::countAllocation();
+        *ptr = __libc_memalign(alignment, size);
+        return *ptr != nullptr ? 0 : ENOMEM;
+    }
+}
+
+#else
+
+void* operator new (std::size_t size)
+{
+    ScopedAudioThreadCheck::countAllocation();
+
+    if (void* ptr = std::malloc(size == 0 ? 1 : size))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[] (std::size_t size)
+{
+    return operator new (size);
+}
+
+void operator delete (void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[] (void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete (void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[] (void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+#endif
+
+#endif
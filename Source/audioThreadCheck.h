@@ -0,0 +1,88 @@
+/*
+  ==============================================================================
+
+    audioThreadCheck.h
+    Created: 16 Oct 2026 1:47:09pm
+    Author:  Christopher Duvall
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ Debug check that the audio thread never touches the system allocator.
+
+ processBlock creates a ScopedAudioThreadCheck. While it's alive, every allocation on that thread is counted,
+ when processBlock returns the destructor asserts that nothing was allocated.
+ The counting is done by allocationCounter.h, which only the drone's own console executables include.
+ In the plugin nothing gets counted and the check never fires, hosts keep their own allocator.
+
+ On by default in debug builds, compiles away in release.
+ Set DRONE_CHECK_AUDIO_ALLOCATIONS to 0 or 1 in the project's preprocessor definitions to override.
+*/
+
+#ifndef DRONE_CHECK_AUDIO_ALLOCATIONS
+ #if JUCE_DEBUG
+  #define DRONE_CHECK_AUDIO_ALLOCATIONS 1
+ #else
+  #define DRONE_CHECK_AUDIO_ALLOCATIONS 0
+ #endif
+#endif
+
+class ScopedAudioThreadCheck
+{
+public:
+#if DRONE_CHECK_AUDIO_ALLOCATIONS
+    ScopedAudioThreadCheck()
+    {
+        startCount = getAllocationCount();
+        isInsideAudioCallback() = true;
+    }
+
+    ~ScopedAudioThreadCheck()
+    {
+        isInsideAudioCallback() = false;
+
+        // something in processBlock allocated memory, see getAllocationCount()
+        jassert(getAllocationCount() == startCount);
+    }
+
+    // called from the counting allocator, can't allocate or assert in here
+    static void countAllocation()
+    {
+        if (isInsideAudioCallback())
+            getAllocationCount()++;
+    }
+
+    // total allocations made inside audio callbacks since the plugin loaded
+    static int getAllocations()
+    {
+        return getAllocationCount().load();
+    }
+
+private:
+    static bool& isInsideAudioCallback()
+    {
+        static thread_local bool inside = false;
+        return inside;
+    }
+
+    static std::atomic<int>& getAllocationCount()
+    {
+        static std::atomic<int> count { 0 };
+        return count;
+    }
+
+    int startCount = 0;
+#else
+    ScopedAudioThreadCheck() {}
+
+    static int getAllocations()
+    {
+        return 0;
+    }
+#endif
+};
@@ -0,0 +1,572 @@
+/*
+  ==============================================================================
+
+    chaseSwarm.h
+    Created: 17 Oct 2026 5:18:36pm
+    Author:  Christopher Duvall
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "osc.h"
+#include "oscBank.h"
+#include "effects.h"
+#include "snapshot.h"
+
+/**
+ A whole swarm of chase synths: 1 - maxChasers chasers, each with its own target, speed, pan and distortion.
+
+ Every chaser is ChasingSynth's chase (a band limited triangle and its detuned twin gliding up or down to a target,
+ distortion strongest at the start of each chase, pan bouncing from side to side on every catch).
+ Chasers are stored side by side (structure of arrays) instead of one object each: the oscillators are one
+ OscillatorBank, rendered with SIMD registers, the chase and pan state are float arrays that the control tick
+ goes through in a branch free loop, so it vectorises too, and the distortion runs a register of chasers at a time.
+ Catches need random numbers, so they get a second, scalar pass over only the chasers that caught something.
+
+ Targets come from two places in the thick synth: even chasers follow its filter cutoff at their own ratio
+ (chaser 0 at 1, the same target ChasingSynth has), odd chasers head for a partial of its base frequency,
+ a new one every catch.
+
+ A SpatialPanner per chaser would cost a panner per chaser per sample, so instead the swarm renders into
+ numLanes lanes at fixed pan positions across the whole swing (-1 - 2, see getLanePosition()) and splits every
+ chaser between the two lanes either side of it. The owner places each lane once with a fixed SpatialPanner.
+ In stereo this is the same linear pan ChasingSynth gets, in other layouts it's very close.
+ Pans glide to their new position over a control period, like SpatialPanner.
+
+ Distortion is Effects' tanh and ADAA clip, per chaser, without oversampling, in float SIMD registers
+ (Effects does the clip in double, see distort()).
+ After it every chaser is turned down by 1 / sqrt(number of chasers). Chasers aren't in step with each other,
+ so they add up in power, and the swarm stays about as loud as one chase synth at any size
+ (a lone chaser is left at full level, exactly ChasingSynth's).
+ Nothing allocates once prepare() is done.
+*/
+
+class ChaseSwarm
+{
+public:
+    using SIMD = juce::dsp::SIMDRegister<float>;
+
+    static constexpr int maxChasers = 256;
+    static constexpr int numLanes = 9; // fixed pan positions the chasers are spread over
+
+    // called from the audio thread whenever a chaser catches its target,
+    // with the chaser, the frequency caught and the sample in the current renderBlock() it happened at
+    std::function<void(int, float, int)> onCatch;
+
+    // -------- SETTERS -------- //
+
+    // sample rate, control rate and number of chasers (1 - maxChasers), never call from the audio thread
+    // only reallocates when the number of chasers or the control rate changed,
+    // chases already going carry on at the new rate, a swarm with new chasers needs reset() before it plays
+    void prepare(double SR, int rate, int chasers)
+    {
+        int newCount = juce::jlimit(1, maxChasers, chasers);
+        int newRate = juce::jmax(1, rate);
+        int simdSize = (int)SIMD::size();
+
+        if (newCount != numChasers || newRate != controlRate)
+        {
+            numChasers = newCount;
+            controlRate = newRate;
+            level = 1.0f / std::sqrt((float)numChasers);
+            capacity = ((numChasers + simdSize - 1) / simdSize) * simdSize;
+            samplesToControl = 0;
+
+            // every per chaser array in one block, the first lined up for SIMD loads
+            storage.allocate((size_t)(capacity * numArrays + alignment), true);
+            float* base = juce::snapPointerToAlignment(storage.getData(), (size_t)alignment * sizeof(float));
+
+            target = base;
+            startFreq = target + capacity;
+            detune = startFreq + capacity;
+            lfoPhase = detune + capacity;
+            lfoFreq = lfoPhase + capacity;
+            mod = lfoFreq + capacity;
+            freq = mod + capacity;
+            up = freq + capacity;
+            panSwitch = up + capacity;
+            pan = panSwitch + capacity;
+            prevPan = pan + capacity;
+            ratio = prevPan + capacity;
+            harmonic = ratio + capacity;
+            lastInput = harmonic + capacity;
+            caught = lastInput + capacity;
+
+            // a control period of every chaser, one sample's chasers after another
+            blockStorage.allocate((size_t)(capacity * controlRate + alignment), true);
+            block = juce::snapPointerToAlignment(blockStorage.getData(), (size_t)alignment * sizeof(float));
+
+            // the same once distorted, turned around to one chaser's samples after another for mix()
+            runs.allocate((size_t)(capacity * controlRate), true);
+
+            // mains, then their detuned twins
+            bank.setCapacity(2 * capacity);
+
+            for (int v = 0; v < bank.getCapacity(); v++)
+            {
+                bank.setWaveType(v, OscillatorBank::triangle);
+                bank.setBandLimited(v, true); // PolyBLAMP, chasers reach several kHz
+            }
+        }
+
+        sampleRate = SR;
+        bank.setSampleRate((float)SR); // keeps every chaser's frequency
+
+        // jumps straight to the latest shape
+        smoothTanGain.reset(SR, smoothingSeconds);
+        smoothDistReturn.reset(SR, smoothingSeconds);
+        tanGain = smoothTanGain.getCurrentValue();
+        distReturn = smoothDistReturn.getCurrentValue();
+    }
+
+    // every chaser back to the start of its first chase, from the seed (setSeed() first for a different swarm)
+    // never allocates, call after prepare, whenever the swarm isn't rendering
+    void reset()
+    {
+        random.setSeed(pieceSeed); // same swarm every time
+        std::fill(target, target + capacity * numArrays, 0.0f); // padding too, so SIMD lanes past the end stay quiet
+        samplesToControl = 0;
+
+        for (int c = 0; c < numChasers; c++)
+        {
+            bool lead = c == 0;
+
+            ratio[c] = lead ? 1.0f : (c % 2 == 0 ? cutoffRatios[random.nextInt(numCutoffRatios)] : 0.0f);
+            harmonic[c] = (float)(minHarmonic + random.nextInt(maxHarmonic - minHarmonic + 1));
+            target[c] = lead ? 700.0f : 200.0f + random.nextFloat() * 1800.0f;
+            up[c] = 1.0f;
+            panSwitch[c] = lead || random.nextBool() ? 0.0f : 1.0f;
+            pan[c] = prevPan[c] = panSwitch[c]; // mod starts at 0
+            lfoPhase[c] = lead ? 0.0f : random.nextFloat(); // out of step with each other
+            lfoFreq[c] = lead ? firstLfoFreq : random.nextFloat() * 1.1f;
+            startFreq[c] = target[c] / 2.0f;
+            detune[c] = random.nextFloat() + 1.0f;
+            freq[c] = startFreq[c];
+        }
+
+        for (int v = 0; v < bank.getCapacity(); v++)
+        {
+            bank.resetPhase(v);
+            bank.deactivate(v, 0);
+        }
+
+        for (int c = 0; c < numChasers; c++)
+        {
+            bank.setFreq(c, freq[c]);
+            bank.setFreq(capacity + c, freq[c] * detune[c]);
+            bank.activate(c, 0);
+            bank.activate(capacity + c, 0);
+        }
+    }
+
+    void setSeed(juce::int64 seed) // seed for random, see RandomSource, reset() starts from it again
+    {
+        pieceSeed = seed;
+        random.setSeed(seed);
+    }
+
+    void setDistortion(float newTanGain, float newDistReturn) // distortion drive and clip level, glides there, see Effects
+    {
+        smoothTanGain.setTargetValue(newTanGain);
+        smoothDistReturn.setTargetValue(newDistReturn);
+    }
+
+    // -------- GETTERS -------- //
+    int getNumChasers()
+    {
+        return numChasers;
+    }
+
+    float getFrequency(int chaser) // main oscillator, where the chase is now
+    {
+        return freq[chaser];
+    }
+
+    float getTarget(int chaser) // frequency being chased
+    {
+        return target[chaser];
+    }
+
+    float getPanPosition(int chaser) // 1 = left, 0 = right (swings past both), see SpatialPanner
+    {
+        return pan[chaser];
+    }
+
+    static float getLanePosition(int lane) // pan position of a lane, -1 - 2 evenly
+    {
+        return -1.0f + 3.0f * (float)lane / (float)(numLanes - 1);
+    }
+
+    // -------- SNAPSHOT -------- //
+    // every chaser's arrays straight out of storage, the oscillators and the distortion shape, see snapshot.h
+    // reads back into a swarm prepared with the same number of chasers and control rate
+    void writeSnapshot(SnapshotWriter& writer)
+    {
+        writer.write(random.getSeed());
+        writer.writeArray(target, capacity * numArrays);
+        bank.writeSnapshot(writer);
+        writer.write(tanGain);
+        writer.write(distReturn);
+        writer.writeSmoothed(smoothTanGain);
+        writer.writeSmoothed(smoothDistReturn);
+        writer.write(samplesToControl);
+    }
+
+    void readSnapshot(SnapshotReader& reader)
+    {
+        juce::int64 seed = random.getSeed();
+        reader.read(seed);
+        random.setSeed(seed);
+
+        reader.readArray(target, capacity * numArrays);
+        bank.readSnapshot(reader);
+        reader.read(tanGain);
+        reader.read(distReturn);
+        reader.readSmoothed(smoothTanGain);
+        reader.readSmoothed(smoothDistReturn);
+        reader.read(samplesToControl);
+    }
+
+    // -------- PROCESS -------- //
+    // fills numLanes lanes with numSamples of the swarm, each lane to be placed at getLanePosition()
+    // cutoffs holds the thick synth filter cutoff for every sample (read at control rate),
+    // harmonicBase is the thick synth's base frequency, partials of it are the odd chasers' targets
+    void renderBlock(float* const* lanes, const float* cutoffs, float harmonicBase, int numSamples)
+    {
+        for (int l = 0; l < numLanes; l++)
+            std::fill(lanes[l], lanes[l] + numSamples, 0.0f);
+
+        int done = 0;
+
+        while (done < numSamples)
+        {
+            if (samplesToControl == 0)
+            {
+                blockPosition = done;
+                controlTick(cutoffs[done], harmonicBase);
+                samplesToControl = controlRate;
+            }
+
+            int run = juce::jmin(numSamples - done, samplesToControl);
+            int rampPosition = controlRate - samplesToControl;
+
+            renderOscillators(run);
+            distort(run);
+
+            for (int c = 0; c < numChasers; c++)
+                mix(c, lanes, done, run, rampPosition);
+
+            done += run;
+            samplesToControl -= run;
+        }
+    }
+
+    // -------- SEEKING -------- //
+    // renderBlock() without the audio, every chase, catch and pan happens exactly as it would
+    // (onCatch isn't called), the oscillators jump ahead a control period at a time
+    void skipBlock(const float* cutoffs, float harmonicBase, int numSamples)
+    {
+        int done = 0;
+        skipping = true;
+
+        while (done < numSamples)
+        {
+            if (samplesToControl == 0)
+            {
+                blockPosition = done;
+                controlTick(cutoffs[done], harmonicBase);
+                samplesToControl = controlRate;
+            }
+
+            int run = juce::jmin(numSamples - done, samplesToControl);
+
+            bank.skip(capacity + numChasers, run);
+            tanGain = smoothTanGain.skip(run);
+            distReturn = smoothDistReturn.skip(run);
+            std::fill(lastInput, lastInput + capacity, 0.0f); // clippers forget, like Effects::skip
+
+            done += run;
+            samplesToControl -= run;
+        }
+
+        skipping = false;
+    }
+
+private:
+    // once every controlRate samples: pan from the last tick's LFO, then every chaser takes a step
+    void controlTick(float cutoff, float harmonicBase)
+    {
+        float lfoStep = (float)(controlRate / sampleRate); // LFO phase per Hz over a control period
+
+        // the common case, still chasing, for every chaser at once
+        for (int c = 0; c < numChasers; c++)
+        {
+            prevPan[c] = pan[c];
+            pan[c] = panSwitch[c] > 0.5f ? 1.0f - mod[c] : mod[c];
+
+            bool goingUp = up[c] > 0.5f;
+            bool chasing = goingUp ? freq[c] < target[c] : freq[c] > target[c];
+
+            // chase catches up at the top of the LFO, see ChasingSynth::chase
+            float start = lfoPhase[c];
+            float end = start + lfoFreq[c] * lfoStep;
+            bool peak = (start < 0.25f && end >= 0.25f) || end >= 1.25f;
+            end -= std::floor(end);
+
+            float m = peak ? 1.0f : FastSine::poly7(end);
+            float moved = goingUp ? startFreq[c] * (m + 1.0f) : startFreq[c] / juce::jmax(m + 1.0f, 1.0e-3f);
+
+            lfoPhase[c] = chasing ? end : 0.0f;
+            mod[c] = chasing ? m : mod[c]; // also the distortion threshold
+            freq[c] = chasing ? moved : freq[c];
+            caught[c] = chasing ? 0.0f : 1.0f;
+        }
+
+        // CAUGHT!
+        for (int c = 0; c < numChasers; c++)
+            if (caught[c] > 0.5f)
+                catchTarget(c, cutoff, harmonicBase);
+
+        // twin follows the main oscillator
+        for (int c = 0; c < numChasers; c++)
+        {
+            bank.setFreq(c, freq[c]);
+            bank.setFreq(capacity + c, freq[c] * detune[c]);
+        }
+    }
+
+    // new target from the chaser's place in the thick synth, new speed, off the other way
+    void catchTarget(int c, float cutoff, float harmonicBase)
+    {
+        float caughtAt = target[c];
+        float next = ratio[c] > 0.0f ? cutoff * ratio[c] / 2.0f : harmonicBase * harmonic[c];
+
+        up[c] = next > target[c] ? 1.0f : 0.0f;
+        target[c] = next;
+        startFreq[c] = up[c] > 0.5f ? next / 2.0f : next * 2.0f; // start below a higher target, above a lower one
+        lfoFreq[c] = random.nextFloat() * 1.1f;
+        detune[c] = random.nextFloat() + 1.0f;
+        panSwitch[c] = 1.0f - panSwitch[c];
+
+        if (ratio[c] == 0.0f)
+            harmonic[c] = (float)(minHarmonic + random.nextInt(maxHarmonic - minHarmonic + 1));
+
+        if (onCatch != nullptr && ! skipping)
+            onCatch(c, caughtAt, blockPosition);
+    }
+
+    // run samples of every chaser into block, before distortion
+    // main and twin summed the way ChasingSynth::renderSample does, (main * vol + twin) * vol
+    void renderOscillators(int run)
+    {
+        const auto vol = SIMD::expand(vectorVol);
+
+        for (int i = 0; i < run; i++)
+        {
+            const float* out = bank.process(capacity + numChasers);
+            float* dest = block + (size_t)i * (size_t)capacity;
+
+            for (int c = 0; c < numChasers; c += (int)SIMD::size())
+                ((SIMD::fromRawArray(out + c) * vol + SIMD::fromRawArray(out + capacity + c)) * vol).copyToRawArray(dest + c);
+        }
+    }
+
+    // Effects' tanh and ADAA clip on every chaser in block, each clipping at its own threshold (its mod),
+    // into runs, one chaser after another
+    // a register of chasers goes through the whole run at a time, so the last input and its integral stay in registers
+    // float instead of Effects' double, the integrals' difference loses about 1e-7 / dx, so it's only divided
+    // across a corner of the clipper, a step that stays on one piece of it is exactly the clipper at its midpoint
+    // (within 3e-5 of Effects)
+    void distort(int run)
+    {
+        tanGain = smoothTanGain.skip(run);
+        distReturn = smoothDistReturn.skip(run);
+
+        const auto gain = SIMD::expand(tanGain);
+        const auto R = SIMD::expand(distReturn);
+        const auto half = SIMD::expand(0.5f);
+        const auto one = SIMD::expand(1.0f);
+        const auto tolerance = SIMD::expand((float)Effects::adaaTolerance);
+
+        for (int c = 0; c < numChasers; c += (int)SIMD::size())
+        {
+            auto T = SIMD::fromRawArray(mod + c);
+            auto x0 = SIMD::fromRawArray(lastInput + c);
+            auto F0 = clipIntegral(x0, T, R); // threshold may have moved since the last run
+            auto side0 = side(x0, T);
+            float* out = runs + (size_t)c * (size_t)controlRate;
+
+            for (int i = 0; i < run; i++)
+            {
+                auto x1 = fastTanh(SIMD::fromRawArray(block + (size_t)i * (size_t)capacity + c) * gain);
+                auto F1 = clipIntegral(x1, T, R);
+                auto side1 = side(x1, T);
+                auto dx = x1 - x0;
+
+                // tiny steps divide badly, use the clipper at the midpoint instead, like steps on one side
+                auto midpoint = SIMD::lessThan(SIMD::abs(dx), tolerance) | SIMD::equal(side0, side1);
+                auto slope = (F1 - F0) * OscillatorBank::reciprocal(dx + (one & midpoint));
+                auto y = slope + ((clip(half * (x0 + x1), T, R) - slope) & midpoint);
+
+                for (size_t k = 0; k < SIMD::size(); k++)
+                    out[k * (size_t)controlRate + (size_t)i] = y.get(k);
+
+                x0 = x1;
+                F0 = F1;
+                side0 = side1;
+            }
+
+            x0.copyToRawArray(lastInput + c);
+        }
+    }
+
+    // SIMD versions of Effects::fastTanh, Effects::clip and Effects::clipIntegral, picking with masks instead of branches
+    static SIMD fastTanh(SIMD x)
+    {
+        x = SIMD::min(SIMD::expand(5.0f), SIMD::max(SIMD::expand(-5.0f), x));
+        auto x2 = x * x;
+        auto num = x * (SIMD::expand(135135.0f) + x2 * (SIMD::expand(17325.0f) + x2 * (SIMD::expand(378.0f) + x2)));
+        auto den = SIMD::expand(135135.0f) + x2 * (SIMD::expand(62370.0f) + x2 * (SIMD::expand(3150.0f) + x2 * SIMD::expand(28.0f)));
+        return SIMD::min(SIMD::expand(1.0f), SIMD::max(SIMD::expand(-1.0f), num * OscillatorBank::reciprocal(den)));
+    }
+
+    static SIMD clip(SIMD x, SIMD T, SIMD R)
+    {
+        const auto zero = SIMD::expand(0.0f);
+
+        auto above = SIMD::greaterThan(x, T);
+        auto below = SIMD::lessThan(x, zero - T) & ~above; // a negative threshold has both, above wins
+
+        return x + ((R - x) & above) + ((zero - R - x) & below);
+    }
+
+    static SIMD clipIntegral(SIMD x, SIMD T, SIMD R)
+    {
+        const auto zero = SIMD::expand(0.0f);
+        const auto half = SIMD::expand(0.5f);
+
+        auto above = SIMD::greaterThan(x, T);
+        auto below = SIMD::lessThan(x, zero - T) & ~above;
+        auto inside = half * x * x;
+        auto corner = half * T * T;
+
+        auto F = inside + ((corner + R * (x - T) - inside) & above) + ((corner - R * (x + T) - inside) & below);
+        auto signSwitch = R * SIMD::abs(x - T); // negative threshold
+
+        return F + ((signSwitch - F) & SIMD::lessThan(T, zero));
+    }
+
+    // which piece of clip() x is on, 1 above the threshold, -1 below, 0 in between
+    static SIMD side(SIMD x, SIMD T)
+    {
+        const auto zero = SIMD::expand(0.0f);
+        const auto one = SIMD::expand(1.0f);
+
+        auto above = SIMD::greaterThan(x, T);
+        auto below = SIMD::lessThan(x, zero - T) & ~above;
+
+        return (one & above) - (one & below);
+    }
+
+    // where a pan position falls between the lanes, 0 - numLanes - 1
+    static float laneCoordinate(float position)
+    {
+        return juce::jlimit(0.0f, (float)(numLanes - 1), (position + 1.0f) / 3.0f * (float)(numLanes - 1));
+    }
+
+    // one chaser's run into the two lanes either side of it, gliding from where it was to where it is
+    // over the control period (rampPosition samples of it already done), at the swarm's level
+    void mix(int c, float* const* lanes, int start, int run, int rampPosition)
+    {
+        float from = laneCoordinate(prevPan[c]);
+        float to = laneCoordinate(pan[c]);
+        int a = juce::jmin((int)from, numLanes - 2);
+        int b = juce::jmin((int)to, numLanes - 2);
+        float fa = from - (float)a;
+        float fb = to - (float)b;
+        const float* x = runs + (size_t)c * (size_t)controlRate;
+
+        if (a == b)
+        {
+            addToLane(lanes[a] + start, x, run, rampPosition, level * (1.0f - fa), level * (1.0f - fb));
+            addToLane(lanes[a + 1] + start, x, run, rampPosition, level * fa, level * fb);
+        }
+        else
+        {
+            addToLane(lanes[a] + start, x, run, rampPosition, level * (1.0f - fa), 0.0f);
+            addToLane(lanes[a + 1] + start, x, run, rampPosition, level * fa, 0.0f);
+            addToLane(lanes[b] + start, x, run, rampPosition, 0.0f, level * (1.0f - fb));
+            addToLane(lanes[b + 1] + start, x, run, rampPosition, 0.0f, level * fb);
+        }
+    }
+
+    // adds a chaser's run into a lane, gain going from gainFrom to gainTo over a control period
+    // both are contiguous and the gain is worked out fresh every sample, so this vectorises
+    void addToLane(float* lane, const float* x, int run, int rampPosition, float gainFrom, float gainTo)
+    {
+        if (gainFrom == 0.0f && gainTo == 0.0f)
+            return;
+
+        float step = (gainTo - gainFrom) / (float)controlRate;
+        float g = gainFrom + step * (float)rampPosition;
+
+        for (int i = 0; i < run; i++)
+            lane[i] += x[i] * (g + step * (float)i);
+    }
+
+    // where chasers get their targets
+    static constexpr int numCutoffRatios = 5;
+    static constexpr float cutoffRatios[numCutoffRatios] = { 0.5f, 0.75f, 1.0f, 1.5f, 2.0f }; // of the filter cutoff
+    static constexpr int minHarmonic = 4; // partials of the thick synth's base frequency
+    static constexpr int maxHarmonic = 32;
+    static constexpr float firstLfoFreq = 0.05f; // chaser 0, same as ChasingSynth's
+    static constexpr float vectorVol = 0.45f; // ChasingSynth's, 0.9 over its two oscillators
+
+    static constexpr int numArrays = 15; // float arrays that live in storage
+    static constexpr int alignment = (int)(SIMD::SIMDRegisterSize / sizeof(float)); // floats, one whole register, so SIMD loads line up
+
+    int numChasers = 0;
+    int capacity = 0; // numChasers rounded up to whole SIMD registers
+    float level = 1.0f; // every chaser's gain into the lanes, 1 / sqrt(numChasers)
+    double sampleRate = 44100.0;
+    int controlRate = 0; // samples between chase / pan updates
+    int samplesToControl = 0; // countdown to next control tick
+    int blockPosition = 0; // sample in renderBlock() of the current control tick
+    bool skipping = false; // inside skipBlock()
+
+    // chaser data, one slot per chaser, all carved out of storage
+    juce::HeapBlock<float> storage;
+    float* target = nullptr; // frequency being chased
+    float* startFreq = nullptr; // where the chase started from (ChasingSynth's vectorFreq)
+    float* detune = nullptr; // twin oscillator ratio
+    float* lfoPhase = nullptr; // chase LFO, 0 - 1
+    float* lfoFreq = nullptr; // chase LFO, Hz, sets the speed
+    float* mod = nullptr; // chase LFO at the last tick, moves frequency, pan and distortion threshold
+    float* freq = nullptr; // main oscillator
+    float* up = nullptr; // 1 going up, 0 going down
+    float* panSwitch = nullptr; // flips each catch
+    float* pan = nullptr; // pan position now
+    float* prevPan = nullptr; // pan position at the last tick, where the glide starts
+    float* ratio = nullptr; // of the filter cutoff, 0 = chases partials instead
+    float* harmonic = nullptr; // partial chased next
+    float* lastInput = nullptr; // clipper input, last sample
+    float* caught = nullptr; // 1 if caught at this tick
+
+    juce::HeapBlock<float> blockStorage;
+    float* block = nullptr; // up to a control period of every chaser, sample after sample
+    juce::HeapBlock<float> runs; // block distorted, controlRate floats per chaser, chaser after chaser
+
+    OscillatorBank bank; // mains 0 - capacity, twins after
+    juce::Random random;
+    juce::int64 pieceSeed = 1; // where random starts at reset()
+
+    // distortion shape, shared by every chaser, see Effects
+    float tanGain = 2.0f;
+    float distReturn = 0.8f;
+    juce::SmoothedValue<float> smoothTanGain { tanGain };
+    juce::SmoothedValue<float> smoothDistReturn { distReturn };
+    static constexpr double smoothingSeconds = 0.05;
+};
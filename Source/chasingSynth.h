@@ -13,7 +13,6 @@
 #include "osc.h"
 #include "effects.h"
 #include <JuceHeader.h>
-#include "PluginProcessor.h"
 
 /**
  This synth creates a high frequency, procedurally generated sonic element.
@@ -21,16 +20,98 @@
  Set up to chase frequencies from thick synth's filter cutoff.
  A very wide range of speeds create an unpredictable, playful quality.
  Calls in a bit-distortion effect, which is at maximum at very beginning of new chase, and will smoothly decrase as gets closer to target frequency
+ 
+ Rendered a block at a time. Chasing, panning and the LFO update every controlRate samples,
+ the per sample path is just the oscillators, distortion runs over each control period as a block.
+ Output is mono, the owner places it with getPanPosition() (SpatialPanner), so it works for any speaker layout.
+ skipBlock() runs the chase forward at control rate without making any sound, for seeking.
 */
 
 class ChasingSynth : Oscillator
 {
     
 public:
+    // called from the audio thread whenever a target is caught,
+    // with the frequency caught and the sample in the current renderBlock() it happened at
+    std::function<void(float, int)> onCatch;
+    
     // -------- SETTERS -------- //
-    void setAllSampleRates(double SR) // LFO sample rate
+    
+    // sample rate and control rate, sizes the voices and the distortion, never call from the audio thread
+    // can be called again any time the synth isn't rendering: a chase that's already going carries on at the new rate,
+    // the voices are only created (and the chase started, see reset()) the first time
+    void prepare(double SR, int rate)
+    {
+        sampleRate = SR;
+        lfo1.setSampleRate(SR); // keeps its frequency
+        lfo1.setSineMode(SineMode::poly7); // -116 dB is plenty for modulation
+        
+        if (rate != controlRate)
+        {
+            controlRate = juce::jmax(1, rate);
+            samplesToControl = 0;
+        }
+        
+        effect.prepare(sampleRate, controlRate); // distortion runs once per control period
+        
+        bool newVoices = (int)oscVector.size() != oscCount;
+        oscVector.resize((size_t)oscCount);
+        
+        for (auto& osc : oscVector)
+        {
+            osc.setSampleRate(SR); // keeps its frequency
+            osc.setBandLimited(true); // PolyBLEP, chase reaches several kHz
+        }
+        
+        if (newVoices)
+            reset();
+    }
+    
+    // back to the start of the chase, from the seed (setSeed() first for a different piece)
+    // never allocates, call after prepare, whenever the synth isn't rendering
+    void reset()
+    {
+        random.setSeed(pieceSeed); // same chase every time
+        targetFreq = 700.0f;
+        newTarget = targetFreq;
+        up = true;
+        panSwitch = false;
+        gain1 = 0.0f;
+        gain2 = 1.0f;
+        mod = 0.0;
+        samplesToControl = 0;
+        blockPosition = 0;
+        
+        lfo1.resetPhase();
+        effect.reset();
+        setAllFrequencies();
+        
+        for (int i = 0; i < oscCount; i++)
+        {
+            oscVector[i].resetPhase();
+            
+            if (i == 0)
+                oscVector[i].setFreq(vectorFreq * (i + 1));
+            
+            else
+                oscVector[i].setFreq((oscVector[i - 1]).getFreq() * 1.1);
+        }
+    }
+    
+    void setDistortionOversampling(int factor) // 1, 2 or 4 (quality renders), takes effect at next prepare
     {
-        lfo1.setSampleRate(SR);
+        effect.setOversampling(factor);
+    }
+    
+    void setDistortion(float tanGain, float distReturn) // distortion drive and clip level, glides there, see Effects
+    {
+        effect.setShape(tanGain, distReturn);
+    }
+    
+    void setSeed(juce::int64 seed) // seed for random, see RandomSource, reset() starts from it again
+    {
+        pieceSeed = seed;
+        random.setSeed(seed);
     }
     
     void setAllFrequencies() // frequencies
@@ -64,24 +145,131 @@ public:
         return gain2;
     }
     
-    // -------- METHODS -------- //
+    // where the synth sits right now, 1 = left, 0 = right (swings past both), see SpatialPanner
+    float getPanPosition()
+    {
+        return gain1;
+    }
+    
+    float getFrequency() // lowest voice, where the chase is now
+    {
+        return oscVector[0].getFreq();
+    }
+    
+    float getTarget() // frequency being chased
+    {
+        return targetFreq;
+    }
     
-    // setup vector
-    void initVector (double SR)
+    // -------- STATE -------- //
+    
+    // everything the chase has got up to, so a saved session carries on from the same place
+    juce::ValueTree getState()
     {
+        juce::ValueTree state ("chasingSynth");
+        state.setProperty("random", random.getSeed(), nullptr);
+        state.setProperty("targetFreq", targetFreq, nullptr);
+        state.setProperty("up", up, nullptr);
+        state.setProperty("panSwitch", panSwitch, nullptr);
+        state.setProperty("vectorFreq", vectorFreq, nullptr);
+        state.setProperty("detune", detune, nullptr);
+        state.setProperty("mod", mod, nullptr);
+        state.setProperty("gain1", gain1, nullptr);
+        state.setProperty("gain2", gain2, nullptr);
+        state.setProperty("lfoFreq", lfo1.getFreq(), nullptr);
+        state.setProperty("lfoPhase", lfo1.getPhase(), nullptr);
+        
         for (int i = 0; i < oscCount; i++)
         {
-            oscVector.push_back(Oscillator());
-            oscVector[i].setSampleRate(SR);
-            
-            if (i == 0)
-                oscVector[i].setFreq(vectorFreq * (i + 1));
-            
-            else
-                oscVector[i].setFreq((oscVector[i - 1]).getFreq() * 1.1);
+            juce::ValueTree voice ("voice");
+            voice.setProperty("freq", oscVector[i].getFreq(), nullptr);
+            voice.setProperty("phase", oscVector[i].getPhase(), nullptr);
+            state.appendChild(voice, nullptr);
         }
+        
+        return state;
     }
     
+    // back to a getState(), call after prepare
+    void setState(const juce::ValueTree& state)
+    {
+        if (! state.hasType("chasingSynth"))
+            return;
+        
+        random.setSeed((juce::int64)state["random"]);
+        targetFreq = state["targetFreq"];
+        up = state["up"];
+        panSwitch = state["panSwitch"];
+        vectorFreq = state["vectorFreq"];
+        detune = state["detune"];
+        mod = state["mod"];
+        gain1 = state["gain1"];
+        gain2 = state["gain2"];
+        lfo1.setFreq(state["lfoFreq"]);
+        lfo1.setPhase(state["lfoPhase"]);
+        effect.adjustDistortion((float)mod);
+        
+        for (int i = 0; i < oscCount && i < state.getNumChildren(); i++)
+        {
+            auto voice = state.getChild(i);
+            oscVector[i].setFreq(voice["freq"]);
+            oscVector[i].setPhase(voice["phase"]);
+        }
+        
+        samplesToControl = 0;
+    }
+    
+    // -------- SNAPSHOT -------- //
+    
+    // getState() bit for bit, plus the distortion, see snapshot.h
+    // reads back into a synth set up with the same sample rate and control rate
+    void writeSnapshot(SnapshotWriter& writer)
+    {
+        writer.write(random.getSeed());
+        lfo1.writeSnapshot(writer);
+        
+        for (auto& osc : oscVector)
+            osc.writeSnapshot(writer);
+        
+        effect.writeSnapshot(writer);
+        writer.write(targetFreq);
+        writer.write(newTarget);
+        writer.write(up);
+        writer.write(panSwitch);
+        writer.write(vectorFreq);
+        writer.write(detune);
+        writer.write(mod);
+        writer.write(gain1);
+        writer.write(gain2);
+        writer.write(samplesToControl);
+    }
+    
+    void readSnapshot(SnapshotReader& reader)
+    {
+        juce::int64 seed = random.getSeed();
+        reader.read(seed);
+        random.setSeed(seed);
+        
+        lfo1.readSnapshot(reader);
+        
+        for (auto& osc : oscVector)
+            osc.readSnapshot(reader);
+        
+        effect.readSnapshot(reader);
+        reader.read(targetFreq);
+        reader.read(newTarget);
+        reader.read(up);
+        reader.read(panSwitch);
+        reader.read(vectorFreq);
+        reader.read(detune);
+        reader.read(mod);
+        reader.read(gain1);
+        reader.read(gain2);
+        reader.read(samplesToControl);
+    }
+    
+    // -------- METHODS -------- //
+    
     // regulate panning
     // mod is lfo frequency
     void pan()
@@ -124,6 +312,9 @@ public:
         targetFreq = newTarget;
         resetFrequencies(); // reset LFO frequency
         setPan(); // keep bouncing back and forth
+        
+        if (onCatch != nullptr && ! skipping)
+            onCatch(prevTarget, blockPosition); // let the delay know
     }
     
     // go after target frequency
@@ -132,7 +323,12 @@ public:
         // chase upwards
         if (oscVector[0].getFreq() < target && up == true)
         {
+            bool peak = lfo1.reachesPeak(controlRate); // chase catches up at top of LFO
+            lfo1.skip(controlRate - 1); // LFO moves once per sample
             mod = lfo1.sineWave(); // mod keeps everything together
+            
+            if (peak)
+                mod = 1.0; // don't step over the top between control ticks
             effect.adjustDistortion(mod); // such as distortion effect
             oscVector[0].setFreq( vectorFreq * (0 + 1) * (mod + 1.0f));
         }
@@ -147,7 +343,12 @@ public:
         // chase downwards (same set up as above)
         else if (oscVector[0].getFreq() > target && up == false)
         {
+            bool peak = lfo1.reachesPeak(controlRate);
+            lfo1.skip(controlRate - 1);
             mod = lfo1.sineWave();
+            
+            if (peak)
+                mod = 1.0;
             effect.adjustDistortion(mod);
             oscVector[0].setFreq( vectorFreq * (0 + 1) / (mod + 1.0f));
         }
@@ -161,39 +362,95 @@ public:
     }
     
     // -------- PROCESS -------- //
-    // top - level control
-    // outputs signal to controlling program
+    // top - level control, once every controlRate samples
     // iterates over sounding vector for frequency modulation
-    float process()
+    void controlTick(float cutoff)
     {
-        pan(); // regulate pan
+        setTarget(cutoff); // thick synth cutoff is the next thing to chase
         
-        float sample = 0.0f;
-        float processedSample = 0.0f;
+        pan(); // regulate pan
         
         chase(targetFreq); // CHASE!
         
+        // base frequency off lowest frequency
+        for (int i = 1; i < oscCount; i += 2)
+            oscVector[i].setFreq((oscVector[i - 1]).getFreq() * detune);
+    }
+    
+    // outputs one sample, before distortion and panning
+    float renderSample()
+    {
+        float sample = 0.0f;
+        
         for (int i = 0; i < oscCount; i++)
         {
-            if (i % 2 == 0)
+            sample += oscVector[i].triWave(); // triangle wave foundation
+            sample *= vectorVol; // regulate vector gain
+        }
+        
+        return sample;
+    }
+    
+    // outputs a mono block to controlling program, and where it should be panned (see getPanPosition()) for every sample
+    // cutoffs holds the thick synth filter cutoff for every sample, only read at control rate
+    void renderBlock(float* output, float* pans, const float* cutoffs, int numSamples)
+    {
+        int done = 0;
+        
+        while (done < numSamples)
+        {
+            if (samplesToControl == 0)
             {
-                sample += oscVector[i].triWave(); // triangle wave foundation
+                blockPosition = done;
+                controlTick(cutoffs[done]);
+                samplesToControl = controlRate;
             }
-                
-            else
+            
+            int run = juce::jmin(numSamples - done, samplesToControl);
+            
+            for (int i = done; i < done + run; i++)
+                output[i] = renderSample();
+            
+            std::fill(pans + done, pans + done + run, getPanPosition());
+            
+            // bring in distortion effect, threshold only changes at control ticks
+            effect.processBlock(output + done, run);
+            
+            done += run;
+            samplesToControl -= run;
+        }
+    }
+    
+    // -------- SEEKING -------- //
+    // renderBlock() without the audio, for jumping ahead in the piece
+    // every chase, catch and pan happens exactly as it would (onCatch isn't called, there's nothing to echo),
+    // the oscillators jump ahead a control period at a time
+    void skipBlock(const float* cutoffs, int numSamples)
+    {
+        int done = 0;
+        skipping = true;
+        
+        while (done < numSamples)
+        {
+            if (samplesToControl == 0)
             {
-                // base frequency off lowest frequency
-                oscVector[i].setFreq((oscVector[i - 1]).getFreq() * detune);
-                sample += oscVector[i].triWave();
+                blockPosition = done;
+                controlTick(cutoffs[done]);
+                samplesToControl = controlRate;
             }
             
-            sample *= vectorVol; // regulate vector gain
+            int run = juce::jmin(numSamples - done, samplesToControl);
+            
+            for (auto& osc : oscVector)
+                osc.skip(run);
+            
+            effect.skip(run);
+            
+            done += run;
+            samplesToControl -= run;
         }
         
-        // bring in distortion effect
-        processedSample = effect.tanDistortion(sample);
-        
-        return processedSample;
+        skipping = false;
     }
     
 private:
@@ -206,8 +463,14 @@ private:
     float vectorFreq; // frequency
     float detune; // detune
     
+    double sampleRate = 44100.0;
+    
     // LFO variables
     float lfoFreq1 = 0.05f; // frequency
+    int controlRate = 32; // samples between chase / pan updates
+    int samplesToControl = 0; // countdown to next control tick
+    int blockPosition = 0; // sample in renderBlock() of the current control tick
+    bool skipping = false; // inside skipBlock()
     
     // panning variables
     float gain1 = 0.0f; // left
@@ -230,4 +493,5 @@ private:
     Effects effect;
     
     juce::Random random;
+    juce::int64 pieceSeed = 1; // where random starts at reset()
 };
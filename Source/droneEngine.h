@@ -0,0 +1,353 @@
+/*
+  ==============================================================================
+
+    droneEngine.h
+    Created: 16 Oct 2026 7:08:26pm
+    Author:  Christopher Duvall
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+/**
+ Runs many independent drones at once, for installations with one drone per speaker zone.
+ Owns numInstances Drone_pieceAudioProcessors (each with its own seed) and renders their blocks in parallel,
+ then routes each drone's stereo output into a multichannel buffer.
+
+ Work stealing: every block, each thread gets its own range of drones. A thread renders from the front of its range,
+ and when that's empty it steals from the back of another thread's range, so uneven drones still finish together.
+ Ranges are a begin / end pair packed into one atomic, so taking or stealing a job is a single compare and swap.
+ Dispatch doesn't lock or allocate. The thread calling process() works through its own range as well.
+
+ Idle workers spin briefly between blocks, then sleep until the next one.
+*/
+
+class DroneEngine
+{
+public:
+    // -------- CONSTRUCTOR -------- //
+    DroneEngine() {};
+
+    ~DroneEngine()
+    {
+        stopWorkers();
+    }
+
+    // -------- SETTERS -------- //
+
+    // creates the drones (seeded baseSeed, baseSeed + 1...) and numThreads - 1 worker threads
+    // every drone is routed to its own stereo pair, wrapping around numOutputChannels
+    // allocates, never call from the audio thread
+    void prepare(int numInstances, int numOutputChannels, double SR, int blockSize, int numThreads, juce::int64 baseSeed)
+    {
+        stopWorkers();
+
+        instances = juce::jmax(1, numInstances);
+        threads = juce::jlimit(1, instances, numThreads);
+        outputChannels = juce::jmax(1, numOutputChannels);
+        maxBlock = juce::jmax(1, blockSize);
+
+        drones.clear();
+        buffers.clear();
+        midi.clear();
+        routes.clear();
+
+        for (int i = 0; i < instances; i++)
+        {
+            auto* drone = drones.add(new Drone_pieceAudioProcessor());
+            drone->setSeed(baseSeed + i);
+            drone->setDistortionOversampling(distortionOversampling);
+            drone->setReverbEngine(reverbLines);
+            drone->setChasers(chasers);
+            drone->setRateAndBufferSizeDetails(SR, maxBlock);
+            drone->prepareToPlay(SR, maxBlock);
+
+            buffers.add(new juce::AudioBuffer<float>(juce::jmax(2, drone->getTotalNumOutputChannels()), maxBlock));
+            midi.add(new juce::MidiBuffer());
+        }
+
+        // default routing, drones share output pairs evenly, quieter the more there are on a pair
+        int pairs = juce::jmax(1, outputChannels / 2);
+        int perPair = (instances + pairs - 1) / pairs;
+        float gain = 1.0f / std::sqrt((float)perPair);
+
+        for (int i = 0; i < instances; i++)
+            routes.push_back({ (2 * i) % outputChannels, (2 * i + 1) % outputChannels, gain });
+
+        ranges.reset(new JobRange[(size_t)threads]);
+
+        for (int w = 0; w < threads - 1; w++)
+        {
+            auto* worker = workers.add(new Worker(*this, w));
+            worker->startThread(9); // just under the audio thread
+        }
+    }
+
+    // chase synth distortion oversampling for every drone, 1, 2 or 4, takes effect at next prepare
+    void setDistortionOversampling(int factor)
+    {
+        distortionOversampling = factor;
+    }
+
+    // reverb for every drone, 0 = juce::Reverb, 4, 8 or 16 = FdnReverb lines, takes effect at next prepare
+    void setReverbEngine(int lines)
+    {
+        reverbLines = lines;
+    }
+
+    // chasers for every drone, 1 = chase synth, more = a ChaseSwarm, takes effect at next prepare
+    void setChasers(int count)
+    {
+        chasers = count;
+    }
+
+    // where one drone's left and right go in the output, and how loud
+    void setRoute(int instance, int leftChannel, int rightChannel, float gain)
+    {
+        jassert(instance >= 0 && instance < instances && leftChannel >= 0 && rightChannel >= 0);
+
+        if (instance < 0 || instance >= instances)
+            return;
+
+        // wraps around the output channels, negative ones from the top
+        auto wrap = [this] (int channel) { return (channel % outputChannels + outputChannels) % outputChannels; };
+        routes[(size_t)instance] = { wrap(leftChannel), wrap(rightChannel), gain };
+    }
+
+    // -------- GETTERS -------- //
+    int getNumInstances()
+    {
+        return instances;
+    }
+
+    int getNumThreads()
+    {
+        return threads;
+    }
+
+    Drone_pieceAudioProcessor* getInstance(int instance)
+    {
+        return drones[instance];
+    }
+
+    // -------- PROCESS -------- //
+
+    // renders one block of every drone and mixes them into output (numOutputChannels, up to blockSize samples)
+    // lock free and allocation free
+    void process(juce::AudioBuffer<float>& output)
+    {
+        int numSamples = juce::jmin(output.getNumSamples(), maxBlock);
+        blockSamples.store(numSamples, std::memory_order_relaxed);
+        remaining.store(instances, std::memory_order_relaxed);
+
+        // hand every thread an even slice, stealing evens out the rest
+        for (int w = 0; w < threads; w++)
+            ranges[w].range.store(pack(w * instances / threads, (w + 1) * instances / threads), std::memory_order_release);
+
+        // seq_cst, pairs with the worker's sleeping store then generation load, see Worker::run
+        generation.fetch_add(1, std::memory_order_seq_cst);
+
+        for (auto* worker : workers)
+            worker->wake();
+
+        // this thread is the last worker
+        runJobs(threads - 1);
+
+        while (remaining.load(std::memory_order_acquire) > 0)
+            juce::Thread::yield();
+
+        // route every drone into the output
+        output.clear();
+
+        for (int i = 0; i < instances; i++)
+        {
+            const auto& route = routes[(size_t)i];
+            output.addFrom(route.left, 0, *buffers[i], 0, 0, numSamples, route.gain);
+            output.addFrom(route.right, 0, *buffers[i], 1, 0, numSamples, route.gain);
+        }
+    }
+
+private:
+    // ---- JOBS ---- //
+
+    // one block of one drone
+    void renderInstance(int instance)
+    {
+        int numSamples = blockSamples.load(std::memory_order_relaxed);
+
+        // view of the preallocated buffer at this block's length, doesn't allocate
+        juce::AudioBuffer<float> block (buffers[instance]->getArrayOfWritePointers(), buffers[instance]->getNumChannels(), numSamples);
+        block.clear();
+
+        drones[instance]->processBlock(block, *midi[instance]);
+    }
+
+    // keeps taking jobs until there are none left anywhere
+    void runJobs(int worker)
+    {
+        int job;
+
+        while ((job = takeOwn(worker)) >= 0 || (job = steal(worker)) >= 0)
+        {
+            renderInstance(job);
+            remaining.fetch_sub(1, std::memory_order_acq_rel);
+        }
+    }
+
+    // front of this thread's own range
+    int takeOwn(int worker)
+    {
+        auto& range = ranges[worker].range;
+        auto current = range.load(std::memory_order_acquire);
+
+        while (begin(current) < end(current))
+        {
+            if (range.compare_exchange_weak(current, pack(begin(current) + 1, end(current)), std::memory_order_acq_rel))
+                return begin(current);
+        }
+
+        return -1;
+    }
+
+    // back of the first other range with work left
+    int steal(int worker)
+    {
+        for (int k = 1; k < threads; k++)
+        {
+            auto& range = ranges[(worker + k) % threads].range;
+            auto current = range.load(std::memory_order_acquire);
+
+            while (begin(current) < end(current))
+            {
+                if (range.compare_exchange_weak(current, pack(begin(current), end(current) - 1), std::memory_order_acq_rel))
+                    return end(current) - 1;
+            }
+        }
+
+        return -1;
+    }
+
+    static juce::uint64 pack(int first, int last)
+    {
+        return ((juce::uint64)(juce::uint32)last << 32) | (juce::uint32)first;
+    }
+
+    static int begin(juce::uint64 range)
+    {
+        return (int)(juce::uint32)(range & 0xffffffffu);
+    }
+
+    static int end(juce::uint64 range)
+    {
+        return (int)(juce::uint32)(range >> 32);
+    }
+
+    // ---- WORKERS ---- //
+    class Worker : public juce::Thread
+    {
+    public:
+        Worker(DroneEngine& e, int i) : juce::Thread("drone worker " + juce::String(i)), engine(e), index(i) {};
+
+        // called from process(), only signals if the worker went to sleep
+        void wake()
+        {
+            if (sleeping.exchange(false, std::memory_order_seq_cst))
+                wakeUp.signal();
+        }
+
+        void run() override
+        {
+            juce::uint32 seen = engine.generation.load(std::memory_order_acquire);
+            int spins = 0;
+
+            while (! threadShouldExit())
+            {
+                juce::uint32 current = engine.generation.load(std::memory_order_acquire);
+
+                if (current != seen)
+                {
+                    seen = current;
+                    spins = 0;
+                    engine.runJobs(index);
+                    continue;
+                }
+
+                // blocks come often, spin for a while before sleeping
+                if (++spins < maxSpins)
+                {
+                    juce::Thread::yield();
+                    continue;
+                }
+
+                // all seq_cst, so either this load sees the new block or process()'s wake() sees sleeping
+                // (acquire / release would let the store and load pass each other and lose the wake)
+                sleeping.store(true, std::memory_order_seq_cst);
+
+                if (engine.generation.load(std::memory_order_seq_cst) == seen)
+                    wakeUp.wait(1); // timeout only matters for stopWorkers(), which can't go through generation
+
+                sleeping.store(false, std::memory_order_release);
+                spins = 0;
+            }
+        }
+
+    private:
+        static constexpr int maxSpins = 2000;
+
+        DroneEngine& engine;
+        int index;
+        std::atomic<bool> sleeping { false };
+        juce::WaitableEvent wakeUp;
+    };
+
+    void stopWorkers()
+    {
+        for (auto* worker : workers)
+            worker->signalThreadShouldExit();
+
+        for (auto* worker : workers)
+        {
+            worker->wake();
+            worker->stopThread(1000);
+        }
+
+        workers.clear();
+    }
+
+    // begin / end of one thread's jobs, on its own cache line so threads don't fight over it
+    struct alignas(64) JobRange
+    {
+        std::atomic<juce::uint64> range { 0 };
+    };
+
+    struct Route
+    {
+        int left;
+        int right;
+        float gain;
+    };
+
+    int instances = 0;
+    int threads = 1;
+    int outputChannels = 2;
+    int maxBlock = 0;
+    int distortionOversampling = 1;
+    int reverbLines = 0;
+    int chasers = 1;
+
+    juce::OwnedArray<Drone_pieceAudioProcessor> drones;
+    juce::OwnedArray<juce::AudioBuffer<float>> buffers; // stereo output of each drone
+    juce::OwnedArray<juce::MidiBuffer> midi;
+    std::vector<Route> routes;
+
+    std::unique_ptr<JobRange[]> ranges;
+    juce::OwnedArray<Worker> workers;
+
+    std::atomic<juce::uint32> generation { 0 }; // goes up once per block, wakes the workers
+    std::atomic<int> remaining { 0 }; // jobs not finished yet this block
+    std::atomic<int> blockSamples { 0 };
+};
@@ -10,9 +10,19 @@
 
 #pragma once
 
+#include <JuceHeader.h>
+#include "snapshot.h"
+
 /**
  Contains distortion effect very similar to week 3 tutorial.
  Ties distortion intensity to an incoming variable for a dynamic effect
+
+ processBlock() is the block version of tanDistortion() for the audio thread:
+ a rational tanh instead of tanhf, and the clipper is anti-aliased with ADAA
+ (antiderivative anti-aliasing, Parker et al. 2016), so the hard edges don't fold back as much.
+ For quality renders setOversampling() runs both at 2x or 4x (juce::dsp::Oversampling, polyphase IIR).
+ The threshold is read once per processBlock() call, tanGain and distReturn (setShape()) glide
+ to new settings over smoothingSeconds, also a processBlock() call at a time.
 */
 
 
@@ -26,17 +36,109 @@ public:
         distThreshold = thresh;
     }
     
+    void setOversampling(int factor) // 1, 2 or 4, takes effect at next prepare
+    {
+        oversampling = factor >= 4 ? 4 : (factor >= 2 ? 2 : 1);
+    }
+    
+    void setShape(float newTanGain, float newDistReturn) // tan drive and clip level, see class notes
+    {
+        smoothTanGain.setTargetValue(newTanGain);
+        smoothDistReturn.setTargetValue(newDistReturn);
+    }
+    
+    // allocates work buffers and the oversampler, never call from the audio thread
+    // maxBlockSize is the most samples any processBlock() call will get
+    // only reallocates when maxBlockSize or the oversampling changed
+    void prepare(double SR, int maxBlockSize)
+    {
+        int newBlock = juce::jmax(1, maxBlockSize);
+    
+        if (newBlock != maxBlock || oversampling != preparedOversampling)
+        {
+            maxBlock = newBlock;
+            preparedOversampling = oversampling;
+            oversampler.reset();
+    
+            if (oversampling > 1)
+            {
+                oversampler.reset(new juce::dsp::Oversampling<float>(1, oversampling == 4 ? 2 : 1,
+                                                                     juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR));
+                oversampler->initProcessing((size_t)maxBlock);
+            }
+    
+            // one extra slot for the last sample of the previous block
+            adaaInput.allocate((size_t)(maxBlock * oversampling + 1), true);
+            adaaIntegral.allocate((size_t)(maxBlock * oversampling + 1), true);
+        }
+    
+        // jumps straight to the latest shape
+        smoothTanGain.reset(SR, smoothingSeconds);
+        smoothDistReturn.reset(SR, smoothingSeconds);
+        tanGain = smoothTanGain.getCurrentValue();
+        distReturn = smoothDistReturn.getCurrentValue();
+    
+        reset();
+    }
+    
+    void reset() // forget previous samples
+    {
+        lastInput = 0.0f;
+    
+        if (oversampler != nullptr)
+            oversampler->reset();
+    }
+    
+    // -------- GETTERS -------- //
+    int getOversampling()
+    {
+        return oversampling;
+    }
+    
+    // -------- SEEKING -------- //
+    // processBlock() without the samples, for seeking: the shape glides on, the clipper forgets its last input
+    void skip(int numSamples)
+    {
+        tanGain = smoothTanGain.skip(numSamples);
+        distReturn = smoothDistReturn.skip(numSamples);
+        lastInput = 0.0f;
+    }
+    
+    // -------- SNAPSHOT -------- //
+    // shape and the clipper's last input, see snapshot.h
+    // the oversampler's filters keep their state to themselves, they start over from silence
+    void writeSnapshot(SnapshotWriter& writer)
+    {
+        writer.write(distThreshold);
+        writer.write(distReturn);
+        writer.write(tanGain);
+        writer.writeSmoothed(smoothTanGain);
+        writer.writeSmoothed(smoothDistReturn);
+        writer.write(lastInput);
+    }
+    
+    void readSnapshot(SnapshotReader& reader)
+    {
+        reset();
+        reader.read(distThreshold);
+        reader.read(distReturn);
+        reader.read(tanGain);
+        reader.readSmoothed(smoothTanGain);
+        reader.readSmoothed(smoothDistReturn);
+        reader.read(lastInput);
+    }
+    
     // -------- PROCESS -------- //
     // bit crush distortion, based on week 3 tutorial
     float distortion(float inSample)
     {
         float outSample = inSample;
-        
+    
         if (outSample > distThreshold)
             outSample = distReturn;
         else if (outSample < -distThreshold)
             outSample = -distReturn;
-        
+    
         return outSample;
     }
     
@@ -45,12 +147,327 @@ public:
     float tanDistortion(float inSample)
     {
         float outSample = inSample * tanGain;
-        
+    
         return distortion(tanhf(outSample));
     }
     
+    // tan distortion on a block, in place, see class notes
+    void processBlock(float* samples, int numSamples)
+    {
+        jassert(numSamples <= maxBlock);
+    
+        tanGain = smoothTanGain.skip(numSamples);
+        distReturn = smoothDistReturn.skip(numSamples);
+    
+        if (oversampler == nullptr)
+        {
+            shape(samples, numSamples);
+            return;
+        }
+    
+        float* channels[] = { samples };
+        juce::dsp::AudioBlock<float> block (channels, 1, (size_t)numSamples);
+    
+        auto up = oversampler->processSamplesUp(block);
+        shape(up.getChannelPointer(0), (int)up.getNumSamples());
+        oversampler->processSamplesDown(block);
+    }
+    
+    // -------- SHAPES -------- //
+    // the pieces of processBlock(), ChaseSwarm has SIMD versions of them to run per chaser
+    
+    // distortion() as a pure function
+    static double clip(double x, double T, double R)
+    {
+        return x > T ? R : (x < -T ? -R : x);
+    }
+    
+    // antiderivative of clip(), continuous so ADAA differences stay smooth
+    // a negative threshold makes clip() a plain sign switch at T
+    static double clipIntegral(double x, double T, double R)
+    {
+        if (T < 0.0)
+            return R * std::abs(x - T);
+    
+        return x > T ? 0.5 * T * T + R * (x - T)
+                     : (x < -T ? 0.5 * T * T - R * (x + T) : 0.5 * x * x);
+    }
+    
+    // rational tanh (Lambert's continued fraction), error under 1e-6 to +-3 and 1e-4 at +-5, clamped past that
+    static float fastTanh(float x)
+    {
+        x = juce::jlimit(-5.0f, 5.0f, x);
+        float x2 = x * x;
+        float num = x * (135135.0f + x2 * (17325.0f + x2 * (378.0f + x2)));
+        float den = 135135.0f + x2 * (62370.0f + x2 * (3150.0f + x2 * 28.0f));
+        return juce::jlimit(-1.0f, 1.0f, num / den);
+    }
+    
+    static constexpr double adaaTolerance = 1.0e-5; // smallest step worth dividing by
+    
 private:
-    float distThreshold; // distortion intensity control
+    // tanh then anti-aliased clip, at whatever rate samples are at
+    void shape(float* samples, int numSamples)
+    {
+        for (int i = 0; i < numSamples; i++)
+            samples[i] = fastTanh(samples[i] * tanGain);
+    
+        // first order ADAA: average of the clipper over each step, (F(x1) - F(x0)) / (x1 - x0)
+        // both passes only look at inputs, so they vectorise
+        const double T = distThreshold;
+        const double R = distReturn;
+    
+        adaaInput[0] = lastInput;
+        adaaIntegral[0] = clipIntegral(lastInput, T, R); // threshold may have moved since last block
+    
+        for (int i = 0; i < numSamples; i++)
+        {
+            adaaInput[i + 1] = samples[i];
+            adaaIntegral[i + 1] = clipIntegral(samples[i], T, R);
+        }
+    
+        for (int i = 0; i < numSamples; i++)
+        {
+            double x0 = adaaInput[i];
+            double x1 = adaaInput[i + 1];
+            double dx = x1 - x0;
+            bool tiny = std::abs(dx) < adaaTolerance;
+    
+            // tiny steps divide badly, use the clipper at the midpoint instead
+            double slope = (adaaIntegral[i + 1] - adaaIntegral[i]) / (tiny ? 1.0 : dx);
+            samples[i] = (float)(tiny ? clip(0.5 * (x0 + x1), T, R) : slope);
+        }
+    
+        lastInput = (float)adaaInput[numSamples];
+    }
+    
+    float distThreshold = 1.0f; // distortion intensity control
     float distReturn = 0.8f; // bit distortion control
     float tanGain = 2.0; // tan distortion control
+    juce::SmoothedValue<float> smoothTanGain { tanGain }; // tanGain and distReturn, gliding to setShape()
+    juce::SmoothedValue<float> smoothDistReturn { distReturn };
+    static constexpr double smoothingSeconds = 0.05; // glide time for setShape()
+    
+    // block processing
+    int oversampling = 1; // 1, 2 or 4
+    int preparedOversampling = 0; // what the buffers and oversampler were set up for
+    int maxBlock = 0;
+    float lastInput = 0.0f; // last clipper input of the previous block
+    juce::HeapBlock<double> adaaInput; // clipper inputs, previous sample first
+    juce::HeapBlock<double> adaaIntegral; // clipIntegral of each input
+    std::unique_ptr<juce::dsp::Oversampling<float>> oversampler;
+};
+
+
+/**
+ Stereo ping pong delay for the chase synth, the echo the piece was always meant to have.
+ Every time the chase synth catches its target, catchTarget() opens the send and kicks the feedback up,
+ then both die away, so only the catches get echoed. The delay time also glides to a new length:
+ high targets give short echoes, low targets long ones.
+
+ The ring buffers are a power of two long (index & mask, no wrap branches), allocated in prepare().
+ Reads are fractional with 4 point Hermite interpolation, so the gliding delay time bends pitch like tape
+ instead of clicking. process() works a block at a time and never allocates.
+*/
+
+class CatchDelay
+{
+public:
+    // -------- SETTERS -------- //
+    
+    // allocates the ring buffers, never call from the audio thread
+    void prepare(double SR, double maxDelaySeconds)
+    {
+        sampleRate = SR;
+    
+        // room for the longest delay plus the interpolation points
+        int size = juce::nextPowerOfTwo((int)std::ceil(maxDelaySeconds * sampleRate) + 4);
+        maxDelaySamples = (float)(size - 4);
+    
+        if (size != mask + 1) // same size lines get cleared by reset()
+        {
+            mask = size - 1;
+            leftLine.allocate((size_t)size, true);
+            rightLine.allocate((size_t)size, true);
+        }
+    
+        glideCoeff = (float)(1.0 - std::exp(-1.0 / (glideSeconds * sampleRate)));
+        catchCoeff = (float)std::exp(-1.0 / (catchDecaySeconds * sampleRate));
+    
+        reset();
+    }
+    
+    void reset() // silent, back to the base delay time
+    {
+        std::fill(leftLine.getData(), leftLine.getData() + mask + 1, 0.0f);
+        std::fill(rightLine.getData(), rightLine.getData() + mask + 1, 0.0f);
+        writePos = 0;
+        catchLevel = 0.0f;
+        numPending = 0;
+        delaySamples = targetDelaySamples = juce::jlimit(2.0f, maxDelaySamples, baseDelaySeconds * (float)sampleRate);
+    }
+    
+    void setBaseDelay(float seconds) // delay time for a catch at the reference frequency
+    {
+        baseDelaySeconds = seconds;
+    }
+    
+    void setFeedback(float resting, float caught) // feedback between catches and right after one
+    {
+        restingFeedback = juce::jlimit(0.0f, 0.95f, resting);
+        catchFeedback = juce::jlimit(0.0f, 0.95f, caught);
+    }
+    
+    // event hook, called when the chase synth catches a target (Hz)
+    // sample is where in the next process() block it happened, so echoes start on the exact sample
+    void catchTarget(float target, int sample)
+    {
+        jassert(numPending < maxPending); // more catches in one block than anyone expects
+    
+        if (numPending < maxPending)
+            pending[numPending++] = { sample, target };
+    }
+    
+    // -------- GETTERS -------- //
+    float getDelaySeconds() // current delay time, part way through a glide
+    {
+        return delaySamples / (float)sampleRate;
+    }
+    
+    // -------- SNAPSHOT -------- //
+    // both ring buffers and the catch envelope, see snapshot.h
+    // called between blocks, so there are no catches waiting
+    void writeSnapshot(SnapshotWriter& writer)
+    {
+        writer.writeArray(leftLine.getData(), mask + 1);
+        writer.writeArray(rightLine.getData(), mask + 1);
+        writer.write(writePos);
+        writer.write(delaySamples);
+        writer.write(targetDelaySamples);
+        writer.write(catchLevel);
+    }
+    
+    void readSnapshot(SnapshotReader& reader)
+    {
+        reader.readArray(leftLine.getData(), mask + 1);
+        reader.readArray(rightLine.getData(), mask + 1);
+        reader.read(writePos);
+        reader.read(delaySamples);
+        reader.read(targetDelaySamples);
+        reader.read(catchLevel);
+        writePos &= mask;
+        numPending = 0;
+    }
+    
+    // -------- PROCESS -------- //
+    
+    // mono in, echoes only (no dry) out, left and right may not alias input
+    void process(const float* input, float* outLeft, float* outRight, int numSamples)
+    {
+        int done = 0;
+        int next = 0;
+    
+        // split the block at every catch
+        while (done < numSamples)
+        {
+            while (next < numPending && pending[next].sample <= done)
+                applyCatch(pending[next++].target);
+    
+            int end = next < numPending ? juce::jmin(numSamples, pending[next].sample) : numSamples;
+            processRun(input, outLeft, outRight, done, end);
+            done = end;
+        }
+    
+        numPending = 0;
+    }
+    
+private:
+    void applyCatch(float target)
+    {
+        catchLevel = 1.0f;
+    
+        // echo time scales with the caught frequency's period, 1 / target
+        float seconds = baseDelaySeconds * referenceFreq / juce::jmax(1.0f, target);
+        targetDelaySamples = juce::jlimit(2.0f, maxDelaySamples, seconds * (float)sampleRate);
+    }
+    
+    void processRun(const float* input, float* outLeft, float* outRight, int start, int end)
+    {
+        float* left = leftLine.getData();
+        float* right = rightLine.getData();
+    
+        for (int i = start; i < end; i++)
+        {
+            delaySamples += glideCoeff * (targetDelaySamples - delaySamples);
+            catchLevel *= catchCoeff;
+    
+            float feedback = restingFeedback + (catchFeedback - restingFeedback) * catchLevel;
+    
+            float wetLeft = read(left, delaySamples);
+            float wetRight = read(right, delaySamples);
+    
+            // ping pong: input goes in on the left, each side feeds the other
+            left[writePos] = input[i] * catchLevel + wetRight * feedback;
+            right[writePos] = wetLeft * feedback;
+    
+            outLeft[i] = wetLeft;
+            outRight[i] = wetRight;
+    
+            writePos = (writePos + 1) & mask;
+        }
+    }
+    
+    // 4 point Hermite read, delay samples behind the write position
+    float read(const float* line, float delay)
+    {
+        int whole = (int)delay;
+        float t = delay - (float)whole;
+    
+        // newest to oldest around the read point
+        float y0 = line[(writePos - whole + 1) & mask];
+        float y1 = line[(writePos - whole) & mask];
+        float y2 = line[(writePos - whole - 1) & mask];
+        float y3 = line[(writePos - whole - 2) & mask];
+    
+        float c1 = 0.5f * (y2 - y0);
+        float c2 = y0 - 2.5f * y1 + 2.0f * y2 - 0.5f * y3;
+        float c3 = 0.5f * (y3 - y0) + 1.5f * (y1 - y2);
+    
+        return ((c3 * t + c2) * t + c1) * t + y1;
+    }
+    
+    double sampleRate = 44100.0;
+    
+    // ring buffers
+    juce::HeapBlock<float> leftLine;
+    juce::HeapBlock<float> rightLine;
+    int mask = 0; // buffer length - 1
+    int writePos = 0;
+    float maxDelaySamples = 2.0f; // Hermite needs one newer sample, so 2 is the shortest delay
+    
+    // delay time
+    float baseDelaySeconds = 0.6f; // echo time for a catch at referenceFreq
+    float referenceFreq = 700.0f; // chase synth's first target
+    float delaySamples = 2.0f;
+    float targetDelaySamples = 2.0f;
+    float glideSeconds = 0.4f; // how long the delay time takes to move
+    float glideCoeff = 1.0f;
+    
+    // catch envelope
+    float restingFeedback = 0.2f;
+    float catchFeedback = 0.7f;
+    float catchDecaySeconds = 1.5f; // send and feedback boost die away over this
+    float catchCoeff = 0.0f;
+    float catchLevel = 0.0f; // 1 right after a catch
+    
+    // catches waiting for the next process()
+    struct Catch
+    {
+        int sample;
+        float target;
+    };
+    
+    static constexpr int maxPending = 16;
+    Catch pending[maxPending];
+    int numPending = 0;
 };
@@ -0,0 +1,182 @@
+/*
+  ==============================================================================
+
+    eventLog.h
+    Created: 17 Oct 2026 9:12:40am
+    Author:  Christopher Duvall
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ Trace of what the piece is doing (catches, gain LFO changes, partials coming and going), safe to write from the audio thread.
+
+ The audio thread push()es fixed size records into a lock-free single producer / single consumer ring (juce::AbstractFifo).
+ No allocation, no locks, no I/O, a full ring drops the record and counts it.
+ A background thread wakes up every flushIntervalMs, turns whatever's queued into text and writes it to a file or stdout.
+
+ Off until start(), push() is a single atomic load until then.
+ Only one thread may push() at a time (the audio thread, or whoever is rendering / seeking while it's stopped).
+*/
+
+class EventLog : private juce::Thread
+{
+public:
+    // add new ones at the end, the numbers show up in logs
+    enum Type
+    {
+        targetCaught = 0, // values: frequency caught, chaser (0 for the chase synth, see ChaseSwarm)
+        gainLFOChanged, // values: voice, new gain LFO frequency (every voice at the start of the piece, then one at a time)
+        partialAdded, // values: partials now sounding
+        partialRemoved // values: partials now sounding
+    };
+
+    struct Record
+    {
+        Type type;
+        juce::int64 time; // samples into the piece
+        float values[2];
+    };
+
+    static constexpr int capacity = 4096; // records queued between flushes
+    static constexpr int flushIntervalMs = 100;
+
+    // -------- CONSTRUCTOR -------- //
+    EventLog() : juce::Thread("drone event log") {};
+
+    ~EventLog() override
+    {
+        stop();
+    }
+
+    // -------- SETTERS -------- //
+    void setSampleRate(double SR) // for printing times in seconds
+    {
+        sampleRate.store(SR);
+    }
+
+    // starts logging to file (appended), or to stdout if file is juce::File(), never call from the audio thread
+    bool start(const juce::File& file)
+    {
+        stop();
+
+        if (file != juce::File())
+        {
+            auto stream = std::make_unique<juce::FileOutputStream>(file);
+
+            if (! stream->openedOk())
+                return false;
+
+            output = std::move(stream);
+        }
+
+        enabled.store(true, std::memory_order_release);
+        startThread();
+        return true;
+    }
+
+    // stops logging, whatever's still queued gets written first
+    void stop()
+    {
+        enabled.store(false, std::memory_order_release);
+        stopThread(flushIntervalMs * 10);
+        flush();
+        output.reset();
+    }
+
+    // -------- AUDIO THREAD -------- //
+    bool isEnabled()
+    {
+        return enabled.load(std::memory_order_acquire);
+    }
+
+    void push(Type type, juce::int64 time, float value1 = 0.0f, float value2 = 0.0f)
+    {
+        if (! isEnabled())
+            return;
+
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite(1, start1, size1, start2, size2);
+
+        if (size1 + size2 == 0)
+        {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        records[size1 > 0 ? start1 : start2] = { type, time, { value1, value2 } };
+        fifo.finishedWrite(1);
+    }
+
+private:
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            wait(flushIntervalMs);
+            flush();
+        }
+    }
+
+    // background thread (or stop()), formats everything queued
+    void flush()
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToRead(fifo.getNumReady(), start1, size1, start2, size2);
+
+        if (size1 + size2 == 0 && dropped.load() == 0)
+            return;
+
+        juce::String text;
+
+        for (int i = 0; i < size1; i++)
+            text << format(records[start1 + i]);
+
+        for (int i = 0; i < size2; i++)
+            text << format(records[start2 + i]);
+
+        fifo.finishedRead(size1 + size2);
+
+        if (auto lost = dropped.exchange(0))
+            text << "(" << (int)lost << " events dropped, log ring full)\n";
+
+        if (output != nullptr)
+        {
+            output->writeText(text, false, false, nullptr);
+            output->flush();
+        }
+        else
+            std::cout << text << std::flush;
+    }
+
+    juce::String format(const Record& r)
+    {
+        juce::String line;
+        line << juce::String(r.time / sampleRate.load(), 3) << " s  (sample " << r.time << ")  ";
+
+        switch (r.type)
+        {
+            case targetCaught:   line << "target caught at " << r.values[0] << " Hz"; break;
+            case gainLFOChanged: line << "gain LFO " << (int)r.values[0] << " -> " << r.values[1] << " Hz"; break;
+            case partialAdded:   line << "partial added, " << (int)r.values[0] << " sounding"; break;
+            case partialRemoved: line << "partial removed, " << (int)r.values[0] << " sounding"; break;
+            default:             line << "event " << (int)r.type; break;
+        }
+
+        if (r.type == targetCaught && r.values[1] > 0.0f) // swarm chasers past the first
+            line << ", chaser " << (int)r.values[1];
+
+        return line + "\n";
+    }
+
+    juce::AbstractFifo fifo { capacity };
+    Record records[capacity] {}; // padding zeroed, records are only ever copied whole
+    std::atomic<bool> enabled { false };
+    std::atomic<juce::uint32> dropped { 0 }; // records that didn't fit since the last flush
+    std::atomic<double> sampleRate { 44100.0 };
+    std::unique_ptr<juce::OutputStream> output; // nullptr = stdout
+};
@@ -0,0 +1,161 @@
+/*
+  ==============================================================================
+
+    eventScheduler.h
+    Created: 16 Oct 2026 6:14:51pm
+    Author:  Christopher Duvall
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "snapshot.h"
+
+/**
+ Timeline of future events, counted in samples since reset().
+ Renderers ask how far they can go before the next event, render up to exactly that sample,
+ then pop whatever is due. Nothing is checked between events.
+
+ Events are just ids, the owner decides what they mean (and usually schedules the next one when handling it).
+ Fixed size and kept sorted, so scheduling never allocates.
+*/
+
+class EventScheduler
+{
+public:
+    static constexpr int maxEvents = 16;
+
+    // -------- SETTERS -------- //
+    void reset() // empty timeline, back to sample 0
+    {
+        numEvents = 0;
+        now = 0;
+    }
+
+    // add an event numSamples from now, same time events come out in the order they went in
+    void scheduleIn(int id, juce::int64 numSamples)
+    {
+        jassert(numEvents < maxEvents); // timeline full, raise maxEvents
+
+        if (numEvents >= maxEvents)
+            return;
+
+        Event e { now + juce::jmax((juce::int64)0, numSamples), id };
+
+        int i = numEvents++;
+        while (i > 0 && events[i - 1].time > e.time) // insertion sort, timeline is tiny
+        {
+            events[i] = events[i - 1];
+            i--;
+        }
+
+        events[i] = e;
+    }
+
+    void cancel(int id) // remove every event with this id
+    {
+        int kept = 0;
+
+        for (int i = 0; i < numEvents; i++)
+            if (events[i].id != id)
+                events[kept++] = events[i];
+
+        numEvents = kept;
+    }
+
+    // -------- GETTERS -------- //
+    juce::int64 getTime() // samples since reset
+    {
+        return now;
+    }
+
+    // how many samples can be rendered before the next event, at most maxSamples
+    int samplesUntilNextEvent(int maxSamples)
+    {
+        if (numEvents == 0)
+            return maxSamples;
+
+        return (int)juce::jmin((juce::int64)maxSamples, events[0].time - now);
+    }
+
+    // samples until the first event with this id, -1 if there isn't one
+    juce::int64 samplesUntil(int id)
+    {
+        for (int i = 0; i < numEvents; i++)
+            if (events[i].id == id)
+                return events[i].time - now;
+
+        return -1;
+    }
+
+    // takes the next event due at the current sample, false once there are none left
+    bool popDueEvent(int& id)
+    {
+        if (numEvents == 0 || events[0].time > now)
+            return false;
+
+        id = events[0].id;
+
+        for (int i = 1; i < numEvents; i++)
+            events[i - 1] = events[i];
+
+        numEvents--;
+        return true;
+    }
+
+    // -------- SNAPSHOT -------- //
+    void writeSnapshot(SnapshotWriter& writer) // the whole timeline, see snapshot.h
+    {
+        writer.write(numEvents);
+        writer.write(now);
+
+        // field by field (an Event's padding would make identical timelines write different bytes),
+        // unused slots as zeros, whatever was popped or cancelled from them doesn't matter
+        for (int i = 0; i < maxEvents; i++)
+        {
+            writer.write(i < numEvents ? events[i].time : (juce::int64)0);
+            writer.write(i < numEvents ? events[i].id : 0);
+        }
+    }
+
+    void readSnapshot(SnapshotReader& reader)
+    {
+        reader.read(numEvents);
+        reader.read(now);
+
+        for (auto& e : events)
+        {
+            reader.read(e.time);
+            reader.read(e.id);
+        }
+
+        numEvents = juce::jlimit(0, maxEvents, numEvents);
+    }
+
+    // -------- METHODS -------- //
+    void advance(int numSamples) // move time forward after rendering
+    {
+        now += numSamples;
+    }
+
+    // after a sample rate change, ratio = new rate / old rate
+    // every event stays the same number of seconds away, the order doesn't change
+    void rescale(double ratio)
+    {
+        for (int i = 0; i < numEvents; i++)
+            events[i].time = now + (juce::int64)std::llround((double)(events[i].time - now) * ratio);
+    }
+
+private:
+    struct Event
+    {
+        juce::int64 time; // sample the event happens at
+        int id;
+    };
+
+    std::array<Event, maxEvents> events {};
+    int numEvents = 0;
+    juce::int64 now = 0;
+};
@@ -0,0 +1,344 @@
+/*
+  ==============================================================================
+
+    fdnReverb.h
+    Created: 16 Oct 2026 10:12:47pm
+    Author:  Christopher Duvall
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "snapshot.h"
+
+/**
+ Cheap stand in for juce::Reverb when lots of drones run at once.
+ A feedback delay network: 4, 8 or 16 delay lines, mixed back into each other through a Hadamard matrix,
+ each with a one pole damping filter. Freeverb needs 8 combs and 4 allpasses per channel (24 delay lines for stereo),
+ this needs one set of lines for both channels.
+
+ Takes the same juce::Reverb::Parameters and tries to sound like it: the decay time matches Freeverb's
+ for the same room size, damping uses the same filter, wet / dry / width are scaled the same way.
+ It's a bit less diffuse at the start of the tail, more lines = denser.
+
+ Processed in chunks no longer than the shortest line, so nothing written during a chunk is read back in it.
+ That lets every step run a whole chunk at a time: each line's output is read as one run of samples,
+ the Hadamard butterflies add and subtract whole rows, and the feedback is written back as one run,
+ all plain loops the compiler vectorises. Only the damping filters run sample by sample (all lines side by side).
+ Buffers are allocated in setSampleRate(), never while processing.
+
+ setParameters() can be called while processing, the gains glide to the new settings a chunk at a time
+ (juce::Reverb smooths its parameters too).
+*/
+
+class FdnReverb
+{
+public:
+    static constexpr int maxLines = 16;
+
+    // -------- SETTERS -------- //
+    void setNumLines(int lines) // 4, 8 or 16, takes effect at next setSampleRate
+    {
+        numLines = lines >= 16 ? 16 : (lines >= 8 ? 8 : 4);
+    }
+
+    // allocates the delay lines, never call from the audio thread
+    void setSampleRate(double SR)
+    {
+        sampleRate = SR;
+        double scale = sampleRate / 44100.0; // lengths below are tuned at 44.1k like Freeverb's
+
+        int longest = 0, shortest = 1 << 30;
+        for (int j = 0; j < numLines; j++)
+        {
+            // spread the subset evenly over the table, so 4 lines still covers short to long
+            int tableIndex = j * (maxLines / numLines) + (maxLines / numLines) / 2;
+            length[j] = juce::jmax(1, (int)std::round(lineTunings[tableIndex] * scale));
+            longest = juce::jmax(longest, length[j]);
+            shortest = juce::jmin(shortest, length[j]);
+        }
+
+        size = juce::nextPowerOfTwo(longest + 1);
+        mask = size - 1;
+        lines.allocate((size_t)(size * numLines), true);
+
+        chunkSize = juce::jmin(maxChunk, shortest);
+        rows.allocate((size_t)(chunkSize * numLines), true);
+        input.allocate((size_t)chunkSize, true);
+        wetLeft.allocate((size_t)chunkSize, true);
+        wetRight.allocate((size_t)chunkSize, true);
+
+        setParameters(parameters); // line gains depend on lengths
+        reset();
+    }
+
+    void setParameters(const juce::Reverb::Parameters& newParameters)
+    {
+        parameters = newParameters;
+        bool frozen = parameters.freezeMode >= 0.5f;
+
+        // same mapping as juce::Reverb
+        float feedback = frozen ? 1.0f : parameters.roomSize * 0.28f + 0.7f;
+        target.dampCoeff = frozen ? 0.0f : parameters.damping * 0.4f;
+
+        float wet = parameters.wetLevel * 3.0f;
+        target.wet1 = 0.5f * wet * (1.0f + parameters.width);
+        target.wet2 = 0.5f * wet * (1.0f - parameters.width);
+        target.dry = parameters.dryLevel * 2.0f;
+
+        // Freeverb loses (1 - feedback) every average comb length, every line here decays at that same rate
+        double scale = sampleRate / 44100.0;
+        for (int j = 0; j < numLines; j++)
+            target.lineGain[j] = (float)std::pow((double)feedback, length[j] / (freeverbCombLength * scale)) / std::sqrt((float)numLines); // Hadamard normalisation folded in
+
+        // puts the tail near Freeverb's level from the same input, set by ear rather than measured
+        target.inputGain = frozen ? 0.0f : 0.43f / std::sqrt((float)numLines);
+    }
+
+    void reset() // clears the tail, gains jump to the latest parameters
+    {
+        if (lines.getData() != nullptr)
+            std::fill(lines.getData(), lines.getData() + size * numLines, 0.0f);
+
+        std::fill(damped, damped + maxLines, 0.0f);
+        writePos = 0;
+        gains = target;
+    }
+
+    // -------- GETTERS -------- //
+    int getNumLines()
+    {
+        return numLines;
+    }
+
+    // -------- SNAPSHOT -------- //
+    // the whole tail, damping filters and gliding gains, see snapshot.h
+    void writeSnapshot(SnapshotWriter& writer)
+    {
+        writer.writeArray(lines.getData(), size * numLines);
+        writer.writeArray(damped, maxLines);
+        writer.write(writePos);
+        writer.write(gains);
+    }
+
+    void readSnapshot(SnapshotReader& reader)
+    {
+        reader.readArray(lines.getData(), size * numLines);
+        reader.readArray(damped, maxLines);
+        reader.read(writePos);
+        reader.read(gains);
+        writePos &= mask;
+    }
+
+    // -------- PROCESS -------- //
+    void processStereo(float* left, float* right, int numSamples)
+    {
+        switch (numLines)
+        {
+            case 4:  processLines<4, true>(left, right, numSamples); break;
+            case 8:  processLines<8, true>(left, right, numSamples); break;
+            default: processLines<16, true>(left, right, numSamples); break;
+        }
+    }
+
+    void processMono(float* samples, int numSamples)
+    {
+        switch (numLines)
+        {
+            case 4:  processLines<4, false>(samples, nullptr, numSamples); break;
+            case 8:  processLines<8, false>(samples, nullptr, numSamples); break;
+            default: processLines<16, false>(samples, nullptr, numSamples); break;
+        }
+    }
+
+private:
+    template <int N, bool stereo>
+    void processLines(float* left, float* right, int numSamples)
+    {
+        for (int done = 0; done < numSamples;)
+        {
+            int run = juce::jmin(chunkSize, numSamples - done);
+            processChunk<N, stereo>(left + done, stereo ? right + done : nullptr, run);
+            done += run;
+        }
+    }
+
+    // up to chunkSize samples, rows holds one run of samples per line
+    template <int N, bool stereo>
+    void processChunk(float* left, float* right, int numSamples)
+    {
+        glide<N>(numSamples);
+
+        const float dampCoeff = gains.dampCoeff;
+        const float inputGain = gains.inputGain;
+        const float wet1 = gains.wet1, wet2 = gains.wet2, dry = gains.dry;
+
+        float* row[N];
+        for (int j = 0; j < N; j++)
+            row[j] = rows.getData() + j * chunkSize;
+
+        // read every line's output for the whole chunk
+        for (int j = 0; j < N; j++)
+            copyFromLine(j, (writePos - length[j]) & mask, row[j], numSamples);
+
+        // damp, every line's filter side by side so they don't wait on each other
+        float state[N];
+        std::copy(damped, damped + N, state);
+
+        for (int i = 0; i < numSamples; i++)
+        {
+            for (int j = 0; j < N; j++)
+            {
+                state[j] = row[j][i] + dampCoeff * (state[j] - row[j][i]);
+                row[j][i] = state[j];
+            }
+        }
+
+        std::copy(state, state + N, damped);
+
+        // even lines are the left ear, odd lines the right
+        for (int i = 0; i < numSamples; i++)
+        {
+            wetLeft[i] = 0.0f;
+            wetRight[i] = 0.0f;
+            input[i] = (stereo ? left[i] + right[i] : left[i]) * inputGain;
+        }
+
+        for (int j = 0; j < N; j += 2)
+        {
+            for (int i = 0; i < numSamples; i++)
+            {
+                wetLeft[i] += row[j][i];
+                wetRight[i] += row[j + 1][i];
+            }
+        }
+
+        // mix every line into every other one (Hadamard butterflies, a row at a time)
+        for (int h = 1; h < N; h *= 2)
+        {
+            for (int k = 0; k < N; k += 2 * h)
+            {
+                for (int j = k; j < k + h; j++)
+                {
+                    float* a = row[j];
+                    float* b = row[j + h];
+
+                    for (int i = 0; i < numSamples; i++)
+                    {
+                        float sum = a[i] + b[i];
+                        b[i] = a[i] - b[i];
+                        a[i] = sum;
+                    }
+                }
+            }
+        }
+
+        // feed back, input goes in with alternating signs
+        for (int j = 0; j < N; j++)
+        {
+            float gain = gains.lineGain[j];
+            float sign = (j & 2) ? -1.0f : 1.0f;
+
+            for (int i = 0; i < numSamples; i++)
+                row[j][i] = row[j][i] * gain + input[i] * sign;
+
+            copyToLine(j, writePos, row[j], numSamples);
+        }
+
+        writePos = (writePos + numSamples) & mask;
+
+        for (int i = 0; i < numSamples; i++)
+        {
+            if (stereo)
+            {
+                float dryLeft = left[i];
+                float dryRight = right[i];
+                left[i] = wetLeft[i] * wet1 + wetRight[i] * wet2 + dryLeft * dry;
+                right[i] = wetRight[i] * wet1 + wetLeft[i] * wet2 + dryRight * dry;
+            }
+            else
+            {
+                left[i] = wetLeft[i] * wet1 + left[i] * dry;
+            }
+        }
+    }
+
+    // moves the gains a chunk's worth towards the latest parameters, nothing moves once they're there
+    template <int N>
+    void glide(int numSamples)
+    {
+        float amount = juce::jmin(1.0f, (float)numSamples / (float)(glideSeconds * sampleRate));
+        auto move = [amount] (float& value, float goal) { value += (goal - value) * amount; };
+
+        move(gains.dampCoeff, target.dampCoeff);
+        move(gains.inputGain, target.inputGain);
+        move(gains.wet1, target.wet1);
+        move(gains.wet2, target.wet2);
+        move(gains.dry, target.dry);
+
+        for (int j = 0; j < N; j++)
+            move(gains.lineGain[j], target.lineGain[j]);
+    }
+
+    // ring buffer copies, in at most two pieces where they wrap
+    void copyFromLine(int line, int start, float* dest, int numSamples)
+    {
+        const float* data = lines.getData() + line * size;
+        int first = juce::jmin(numSamples, size - start);
+
+        std::copy(data + start, data + start + first, dest);
+        std::copy(data, data + (numSamples - first), dest + first);
+    }
+
+    void copyToLine(int line, int start, const float* source, int numSamples)
+    {
+        float* data = lines.getData() + line * size;
+        int first = juce::jmin(numSamples, size - start);
+
+        std::copy(source, source + first, data + start);
+        std::copy(source + first, source + numSamples, data);
+    }
+
+    // delay lengths at 44.1k, primes from 12 to 48 ms so the echoes never line up
+    static constexpr int lineTunings[maxLines] = { 523, 613, 709, 797, 887, 983, 1087, 1187,
+                                                   1297, 1409, 1523, 1637, 1759, 1879, 2003, 2129 };
+    // average of juce::Reverb's comb tunings, 1116 1188 1277 1356 1422 1491 1557 1617 at 44.1k
+    // that's the left channel, the right one adds a stereo spread of 23 (1401), so it rings 1.7% longer
+    static constexpr double freeverbCombLength = 1378.0;
+
+    juce::Reverb::Parameters parameters;
+    double sampleRate = 44100.0;
+    int numLines = 8;
+
+    // delay lines, numLines buffers of size samples back to back
+    juce::HeapBlock<float> lines;
+    int size = 0;
+    int mask = 0;
+    int writePos = 0;
+    int length[maxLines] = {};
+
+    // chunk work buffers
+    static constexpr int maxChunk = 128;
+    int chunkSize = 1;
+    juce::HeapBlock<float> rows; // numLines rows of chunkSize
+    juce::HeapBlock<float> input;
+    juce::HeapBlock<float> wetLeft;
+    juce::HeapBlock<float> wetRight;
+
+    // everything setParameters() works out
+    struct Gains
+    {
+        float lineGain[maxLines] = {}; // decay per trip round each line
+        float dampCoeff = 0.0f;
+        float inputGain = 0.0f;
+        float wet1 = 0.0f, wet2 = 0.0f, dry = 0.0f;
+    };
+
+    Gains gains; // in use
+    Gains target; // latest parameters, gains glide here
+    static constexpr double glideSeconds = 0.05;
+
+    float damped[maxLines] = {}; // damping filter state
+};
@@ -0,0 +1,204 @@
+/*
+  ==============================================================================
+
+    modFilter.h
+    Created: 16 Oct 2026 10:12:40am
+    Author:  Christopher Duvall
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "snapshot.h"
+
+/**
+ Low pass filter built for constant modulation.
+ Replaces rebuilding juce::IIRCoefficients every sample, which costs a tan() and several divides per sample.
+
+ Uses a TPT state variable filter (Zavalishin / Simper). With g = tan(pi * cutoff / SR) and k = 1 / Q
+ the low pass output has exactly the same response as IIRCoefficients::makeLowPass, but it stays stable
+ and click-free while the coefficients move.
+
+ Cutoff and resonance are only read every controlRate samples (16, 32, 64...).
+ In between, the three filter coefficients are ramped linearly towards the new values, so each sample costs
+ a handful of multiplies and adds and no divides.
+*/
+
+class ModFilter
+{
+public:
+    // -------- SETTERS -------- //
+    void prepare(double SR, int rate) // sample rate and control rate, call before processing
+    {
+        sampleRate = SR;
+        setControlRate(rate);
+        reset();
+    }
+
+    void setControlRate(int rate) // how many samples between coefficient updates
+    {
+        controlRate = juce::jmax(1, rate);
+        samplesToUpdate = 0;
+    }
+
+    void setTarget(float CO, float Q) // latest cutoff and resonance, only read at control rate
+    {
+        cutoff = CO;
+        resonance = Q;
+    }
+
+    // -------- GETTERS -------- //
+    int getControlRate()
+    {
+        return controlRate;
+    }
+
+    // -------- METHODS -------- //
+
+    // clear filter memory and jump straight to the current target (no ramp)
+    void reset()
+    {
+        ic1eq = 0.0f;
+        ic2eq = 0.0f;
+
+        computeCoefficients(a1Target, a2Target, a3Target);
+        a1 = a1Target;
+        a2 = a2Target;
+        a3 = a3Target;
+        a1Step = a2Step = a3Step = 0.0f;
+
+        samplesToUpdate = controlRate;
+    }
+
+    // -------- SNAPSHOT -------- //
+    // filter memory and where the coefficient ramp is, see snapshot.h
+    void writeSnapshot(SnapshotWriter& writer)
+    {
+        writer.write(samplesToUpdate);
+        writer.write(cutoff);
+        writer.write(resonance);
+        writer.write(a1); writer.write(a2); writer.write(a3);
+        writer.write(a1Target); writer.write(a2Target); writer.write(a3Target);
+        writer.write(a1Step); writer.write(a2Step); writer.write(a3Step);
+        writer.write(ic1eq);
+        writer.write(ic2eq);
+    }
+
+    void readSnapshot(SnapshotReader& reader)
+    {
+        reader.read(samplesToUpdate);
+        reader.read(cutoff);
+        reader.read(resonance);
+        reader.read(a1); reader.read(a2); reader.read(a3);
+        reader.read(a1Target); reader.read(a2Target); reader.read(a3Target);
+        reader.read(a1Step); reader.read(a2Step); reader.read(a3Step);
+        reader.read(ic1eq);
+        reader.read(ic2eq);
+    }
+
+    // -------- PROCESS -------- //
+    float processSample(float inSample)
+    {
+        if (samplesToUpdate <= 0)
+            updateCoefficients();
+
+        samplesToUpdate--;
+        return tick(inSample);
+    }
+
+    // filters samples in place, cutoffs and resonances hold the settings for every sample
+    // only read when the coefficients update
+    void processBlock(float* samples, const float* cutoffs, const float* resonances, int numSamples)
+    {
+        int done = 0;
+
+        while (done < numSamples)
+        {
+            if (samplesToUpdate <= 0)
+            {
+                setTarget(cutoffs[done], resonances[done]);
+                updateCoefficients();
+            }
+
+            int run = juce::jmin(numSamples - done, samplesToUpdate);
+
+            for (int i = done; i < done + run; i++)
+                samples[i] = tick(samples[i]);
+
+            done += run;
+            samplesToUpdate -= run;
+        }
+    }
+
+private:
+    // one sample through the filter
+    float tick(float inSample)
+    {
+        // ramp coefficients towards control rate target
+        a1 += a1Step;
+        a2 += a2Step;
+        a3 += a3Step;
+
+        // TPT SVF, low pass output
+        float v3 = inSample - ic2eq;
+        float v1 = a1 * ic1eq + a2 * v3;
+        float v2 = ic2eq + a2 * ic1eq + a3 * v3;
+
+        ic1eq = 2.0f * v1 - ic1eq;
+        ic2eq = 2.0f * v2 - ic2eq;
+
+        return v2;
+    }
+
+    // g and k in SVF form, the only place tan() and divides happen
+    void computeCoefficients(float& A1, float& A2, float& A3)
+    {
+        // keep cutoff under nyquist and resonance positive, tan() blows up otherwise
+        double CO = juce::jlimit(1.0, sampleRate * 0.49, (double)cutoff);
+        double Q = juce::jmax(0.01, (double)resonance);
+
+        double g = std::tan(juce::MathConstants<double>::pi * CO / sampleRate);
+        double k = 1.0 / Q;
+
+        double A1d = 1.0 / (1.0 + g * (g + k));
+        A1 = (float)A1d;
+        A2 = (float)(g * A1d);
+        A3 = (float)(g * g * A1d);
+    }
+
+    // new target every controlRate samples, linear ramp until then
+    void updateCoefficients()
+    {
+        // land exactly on previous target so ramp errors don't build up
+        a1 = a1Target;
+        a2 = a2Target;
+        a3 = a3Target;
+
+        computeCoefficients(a1Target, a2Target, a3Target);
+
+        float scale = 1.0f / (float)controlRate;
+        a1Step = (a1Target - a1) * scale;
+        a2Step = (a2Target - a2) * scale;
+        a3Step = (a3Target - a3) * scale;
+
+        samplesToUpdate = controlRate;
+    }
+
+    // filter params
+    double sampleRate = 44100.0;
+    int controlRate = 32; // samples between coefficient updates
+    int samplesToUpdate = 0; // countdown to next update
+    float cutoff = 300.0f;
+    float resonance = 1.0f;
+
+    // coefficients (current, target, per sample step)
+    float a1 = 1.0f, a2 = 0.0f, a3 = 0.0f;
+    float a1Target = 1.0f, a2Target = 0.0f, a3Target = 0.0f;
+    float a1Step = 0.0f, a2Step = 0.0f, a3Step = 0.0f;
+
+    // integrator states
+    float ic1eq = 0.0f;
+    float ic2eq = 0.0f;
+};
@@ -0,0 +1,200 @@
+/*
+  ==============================================================================
+
+    modNoise.h
+    Created: 16 Oct 2026 5:02:48pm
+    Author:  Christopher Duvall
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "snapshot.h"
+
+/**
+ Cheap random modulation for a whole bank of voices, one lane per voice.
+ Each lane is its own xorshift32 generator. A block is filled a sample at a time across all lanes,
+ so the lane loops are plain arrays the compiler turns into SIMD.
+
+ Values are 0 - 1, like juce::Random::nextFloat().
+ setRate() picks how often each lane jumps to a new random value (0 = every sample, white noise),
+ setSmoothing() glides between values with a one pole filter, turning jumps into slow wandering.
+
+ Storage is allocated in prepare() (only when the lane count or block size changes), process() never allocates.
+*/
+
+class ModNoise
+{
+public:
+    // -------- SETTERS -------- //
+
+    // room for numLanes lanes and maxBlockSize samples per process() call, never call from the audio thread
+    // lanes start over from the seed if they had to be reallocated, otherwise they carry on at the new rate
+    void prepare(double SR, int numLanes, int maxBlockSize)
+    {
+        sampleRate = SR;
+        int newLanes = ((juce::jmax(1, numLanes) + 7) / 8) * 8; // whole SIMD registers, no leftover lanes
+        int newBlock = juce::jmax(1, maxBlockSize);
+
+        setRate(rate);
+        setSmoothing(smoothingSeconds);
+
+        if (newLanes == lanes && newBlock == maxBlock)
+            return;
+
+        lanes = newLanes;
+        maxBlock = newBlock;
+
+        state.allocate((size_t)lanes, true);
+        target.allocate((size_t)lanes, true);
+        value.allocate((size_t)lanes, true);
+        block.allocate((size_t)(lanes * maxBlock), true);
+
+        reset();
+    }
+
+    void setSeed(juce::int64 newSeed) // seeds every lane, see RandomSource
+    {
+        seed = newSeed;
+        reset();
+    }
+
+    void setRate(float hz) // new random value this many times a second, 0 = every sample
+    {
+        rate = hz;
+        holdDelta = rate <= 0.0f ? 1.0f : juce::jmin(1.0f, rate / (float)sampleRate);
+    }
+
+    void setSmoothing(float seconds) // glide time between values, 0 = jump straight to them
+    {
+        smoothingSeconds = seconds;
+        smoothCoeff = seconds <= 0.0f ? 1.0f : (float)(1.0 - std::exp(-1.0 / (seconds * sampleRate)));
+    }
+
+    // start every lane over from the seed
+    void reset()
+    {
+        juce::Random seeder(seed);
+
+        for (int j = 0; j < lanes; j++)
+        {
+            state[j] = (juce::uint32)seeder.nextInt() | 1u; // xorshift gets stuck on 0
+            target[j] = 0.0f;
+            value[j] = 0.0f;
+        }
+
+        nextTargets();
+        holdPhase = 0.0f;
+
+        // first values start where they are, instead of gliding up from 0
+        for (int j = 0; j < lanes; j++)
+            value[j] = target[j];
+    }
+
+    // -------- GETTERS -------- //
+    int getNumLanes() // distance between rows in process() output
+    {
+        return lanes;
+    }
+
+    // -------- SEEKING -------- //
+    // jumps numSamples ahead without filling a block
+    // lanes draw one new value if any were due (not one for every value skipped), the glide carries on to it
+    void skip(int numSamples)
+    {
+        holdPhase += holdDelta * (float)numSamples;
+
+        if (holdPhase >= 1.0f)
+        {
+            holdPhase -= std::floor(holdPhase);
+            nextTargets();
+        }
+
+        float glide = 1.0f - std::pow(1.0f - smoothCoeff, (float)numSamples);
+
+        for (int j = 0; j < lanes; j++)
+            value[j] += glide * (target[j] - value[j]);
+    }
+
+    // -------- SNAPSHOT -------- //
+    // every lane's generator and glide, see snapshot.h
+    void writeSnapshot(SnapshotWriter& writer)
+    {
+        writer.writeArray(state.getData(), lanes);
+        writer.writeArray(target.getData(), lanes);
+        writer.writeArray(value.getData(), lanes);
+        writer.write(holdPhase);
+    }
+
+    void readSnapshot(SnapshotReader& reader)
+    {
+        reader.readArray(state.getData(), lanes);
+        reader.readArray(target.getData(), lanes);
+        reader.readArray(value.getData(), lanes);
+        reader.read(holdPhase);
+    }
+
+    // -------- PROCESS -------- //
+
+    // fills numSamples rows, row i (one value per lane) starts at output + i * getNumLanes()
+    // every lane always runs, so a voice's noise doesn't depend on how many voices are sounding
+    const float* process(int numSamples)
+    {
+        jassert(numSamples <= maxBlock);
+
+        for (int i = 0; i < numSamples; i++)
+        {
+            holdPhase += holdDelta;
+
+            if (holdPhase >= 1.0f)
+            {
+                holdPhase -= 1.0f;
+                nextTargets();
+            }
+
+            float* row = block.getData() + i * lanes;
+
+            for (int j = 0; j < lanes; j++)
+            {
+                value[j] += smoothCoeff * (target[j] - value[j]);
+                row[j] = value[j];
+            }
+        }
+
+        return block.getData();
+    }
+
+private:
+    // xorshift32 (Marsaglia) on every lane, top 24 bits become a float 0 - 1
+    void nextTargets()
+    {
+        for (int j = 0; j < lanes; j++)
+        {
+            juce::uint32 x = state[j];
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            state[j] = x;
+
+            target[j] = (float)(x >> 8) * (1.0f / 16777216.0f);
+        }
+    }
+
+    double sampleRate = 44100.0;
+    int lanes = 0;
+    int maxBlock = 0;
+    juce::int64 seed = 1;
+
+    float rate = 0.0f; // new values per second, 0 = every sample
+    float holdDelta = 1.0f; // rate / sample rate
+    float holdPhase = 1.0f; // new values when this passes 1
+    float smoothingSeconds = 0.0f;
+    float smoothCoeff = 1.0f; // one pole coefficient, 1 = no smoothing
+
+    juce::HeapBlock<juce::uint32> state; // xorshift state per lane
+    juce::HeapBlock<float> target; // latest random value per lane
+    juce::HeapBlock<float> value; // smoothed value per lane
+    juce::HeapBlock<float> block; // process() output, maxBlock rows of lanes
+};
@@ -10,12 +10,189 @@
 #define osc_h
 #define TP juce::MathConstants<float>::twoPi
 
+#include "snapshot.h"
+
+
+/**
+Cheaper ways to get sin(2 * pi * phase) for phase 0 - 1, selectable per Oscillator with setSineMode().
+
+ precise     sin() from the standard library, the original behaviour
+ tableLinear 2048 point sine table shared by every oscillator, linear interpolation   (max error about -118 dB)
+ tableCubic  same table, 4 point cubic (Catmull-Rom) interpolation                     (max error about -133 dB, float limited)
+ poly5       5th order minimax polynomial on a quarter cycle, no memory reads          (max error about -83 dB)
+ poly7       7th order minimax polynomial on a quarter cycle                           (max error about -116 dB)
+
+Errors are peak error against double precision sin() for a full scale sine.
+drone_bench measures them along with ns/sample for each mode,
+drone_golden --check fails if a mode comes out more than 1 dB worse than its figure here.
+*/
+
+enum class SineMode
+{
+    precise = 0,
+    tableLinear,
+    tableCubic,
+    poly5,
+    poly7
+};
+
+class FastSine
+{
+public:
+    static constexpr int tableSize = 2048;
+
+    // -------- TABLE -------- //
+    // table[i + 1] = sin(2pi * i / tableSize), with one guard point before and two after for interpolation
+    static const float* getTable()
+    {
+        static const std::array<float, tableSize + 4> table = []
+        {
+            std::array<float, tableSize + 4> t;
+            
+            for (int i = 0; i < tableSize + 4; i++)
+                t[i] = (float)std::sin(juce::MathConstants<double>::twoPi * (i - 1) / tableSize);
+            
+            return t;
+        }();
+        
+        return table.data();
+    }
+    
+    static float tableLinear(float phase)
+    {
+        const float* table = getTable();
+        float pos = phase * tableSize;
+        int i = (int)pos;
+        float frac = pos - i;
+        
+        float a = table[i + 1];
+        float b = table[i + 2];
+        
+        return a + frac * (b - a);
+    }
+    
+    static float tableCubic(float phase)
+    {
+        const float* table = getTable();
+        float pos = phase * tableSize;
+        int i = (int)pos;
+        float frac = pos - i;
+        
+        float y0 = table[i];
+        float y1 = table[i + 1];
+        float y2 = table[i + 2];
+        float y3 = table[i + 3];
+        
+        // Catmull-Rom spline
+        float c1 = 0.5f * (y2 - y0);
+        float c2 = y0 - 2.5f * y1 + 2.0f * y2 - 0.5f * y3;
+        float c3 = 0.5f * (y3 - y0) + 1.5f * (y1 - y2);
+        
+        return ((c3 * frac + c2) * frac + c1) * frac + y1;
+    }
+    
+    // -------- POLYNOMIAL -------- //
+    static float poly5(float phase)
+    {
+        float t = fold(phase);
+        float t2 = t * t;
+        
+        return -t * (6.281280077e+00f + t2 * (-4.109524269e+01f + t2 * 7.358551475e+01f));
+    }
+    
+    static float poly7(float phase)
+    {
+        float t = fold(phase);
+        float t2 = t * t;
+        
+        return -t * (6.283182930e+00f + t2 * (-4.133967160e+01f + t2 * (8.141561135e+01f + t2 * -7.161114305e+01f)));
+    }
+    
+    // any mode by name
+    static float sine(SineMode mode, float phase)
+    {
+        switch (mode)
+        {
+            case SineMode::tableLinear: return tableLinear(phase);
+            case SineMode::tableCubic:  return tableCubic(phase);
+            case SineMode::poly5:       return poly5(phase);
+            case SineMode::poly7:       return poly7(phase);
+            case SineMode::precise:
+            default:                    return sin( phase * TP );
+        }
+    }
+    
+private:
+    // sin(2pi phase) = -sin(2pi t), with t folded into -0.25 - 0.25 where the polynomials are fitted
+    static float fold(float phase)
+    {
+        float t = phase - 0.5f;
+        
+        if (t > 0.25f)
+            t = 0.5f - t;
+        else if (t < -0.25f)
+            t = -0.5f - t;
+        
+        return t;
+    }
+};
+
+
+/**
+PolyBLEP / PolyBLAMP corrections (Valimaki, Pekonen, Nam) for band limited square and triangle waves.
+Each discontinuity is smoothed with a 2 sample polynomial: a step in value for the square wave (BLEP),
+a corner in slope for the triangle wave (BLAMP, the integral of BLEP).
+t is where the oscillator is relative to the discontinuity (0 - 1, discontinuity at 0), dt is phase delta.
+Both are shaped for a jump of 2 (BLEP) or a slope change of 2 per sample (BLAMP), callers scale them.
+Costs a few multiplies per sample, removes most aliasing without oversampling.
+drone_bench reports the aliasing, drone_golden --check fails if it creeps back up (see aliasLimits there).
+*/
+
+class PolyBLEP
+{
+public:
+    static float blep(float t, float dt)
+    {
+        if (t < dt) // just after the jump
+        {
+            float x = t / dt;
+            return x + x - x * x - 1.0f;
+        }
+        
+        if (t > 1.0f - dt) // just before the jump
+        {
+            float x = (t - 1.0f) / dt;
+            return x * x + x + x + 1.0f;
+        }
+        
+        return 0.0f;
+    }
+    
+    static float blamp(float t, float dt)
+    {
+        if (t < dt) // just after the corner
+        {
+            float x = t / dt - 1.0f;
+            return -x * x * x * (1.0f / 3.0f);
+        }
+        
+        if (t > 1.0f - dt) // just before the corner
+        {
+            float x = (t - 1.0f) / dt + 1.0f;
+            return x * x * x * (1.0f / 3.0f);
+        }
+        
+        return 0.0f;
+    }
+};
+
 
 /**
 This oscillator class is based on examples and tutorials from earlier in class.
 The biggest difference is embedded in each Oscillator object, four different oscillator types exsist.
 This is expressly for vector use, so that a vector of Oscillators from osc.h can have a range of timbres.
 Another feature of this Oscillator class is a ability to reset the phase, which is helpful for smoothly going from 0 - 1.
+Square and triangle waves can be switched to band limited (PolyBLEP) versions with setBandLimited().
 
  IMPORTANT: Always initialize sample rate BEFORE initializing frequency. Otherwise phase delta might not be right.
 */
@@ -28,9 +205,10 @@ public:
     
     
     // -------- SETTERS -------- //
-    void setSampleRate(float SR) // sample rate
+    void setSampleRate(float SR) // sample rate, the current frequency carries on at the new rate
     {
         sampleRate = SR;
+        phaseDelta = frequency / sampleRate;
     }
     
     void setFreq(float freq) // frequency and phase delta
@@ -44,11 +222,33 @@ public:
         pulseWidth = pw;
     }
     
+    void setBandLimited(bool shouldBeBandLimited) // PolyBLEP square and triangle waves, see PolyBLEP
+    {
+        bandLimited = shouldBeBandLimited;
+    }
+    
+    void setSineMode(SineMode mode) // how sineWave() gets its values, see FastSine
+    {
+        sineMode = mode;
+        FastSine::getTable(); // build the shared table now, not on the audio thread
+    }
+    
     void resetPhase() // set phase back to 0, for regulating parameters
     {
         phase = 0;
     }
     
+    void skip(int numSamples) // jump phase forward numSamples steps without making sound, for control rate LFO's
+    {
+        phase += phaseDelta * numSamples;
+        phase -= std::floor(phase);
+    }
+    
+    void setPhase(float newPhase) // 0 - 1, for restoring a saved state
+    {
+        phase = newPhase;
+    }
+    
     // -------- GETTERS -------- //
     float getSampleRate()
     {
@@ -60,6 +260,17 @@ public:
         return frequency;
     }
     
+    float getPhase() // 0 - 1
+    {
+        return phase;
+    }
+
+    bool reachesPeak(int numSamples) // true if sine wave hits its peak (phase 0.25) within the next numSamples steps
+    {
+        float end = phase + phaseDelta * numSamples;
+        return (phase < 0.25f && end >= 0.25f) || end >= 1.25f;
+    }
+    
     // -------- METHODS -------- //
     float process() // phasor
     {
@@ -74,12 +285,19 @@ public:
     float sineWave() // sine wave
     {
         //float sineVal = sin( process() * 2 * 3.141592653589793 );
-        float sineVal = sin( process() * TP );
-        return sineVal;
+        float ph = process();
+        
+        if (sineMode == SineMode::precise)
+            return sin( ph * TP );
+        
+        return FastSine::sine(sineMode, ph);
     }
     
     float squareWave() // square wave
     {
+        if (bandLimited)
+            return squareWaveBL();
+        
         float squareVal = 0.5f;
         if (process() > pulseWidth)
             squareVal = -0.5f;
@@ -89,16 +307,67 @@ public:
     
     float triWave() // triangle wave
     {
+        if (bandLimited)
+            return triWaveBL();
+        
         float triVal = fabs(process() - 0.5) - 0.5;
         return triVal * 3;
     }
     
+    // band limited square wave, jumps up 1 at phase 0 and down 1 at pulse width
+    float squareWaveBL()
+    {
+        float ph = process();
+        
+        float t2 = ph - pulseWidth; // phase relative to falling edge
+        if (t2 < 0.0f)
+            t2 += 1.0f;
+        
+        float squareVal = ph >= pulseWidth ? -0.5f : 0.5f;
+        squareVal += 0.5f * PolyBLEP::blep(ph, phaseDelta);
+        squareVal -= 0.5f * PolyBLEP::blep(t2, phaseDelta);
+        
+        return squareVal;
+    }
+    
+    // band limited triangle wave, slope changes by -6 at phase 0 and +6 at phase 0.5
+    float triWaveBL()
+    {
+        float ph = process();
+        
+        float t2 = ph + 0.5f; // phase relative to bottom corner
+        if (t2 >= 1.0f)
+            t2 -= 1.0f;
+        
+        float triVal = (fabsf(ph - 0.5f) - 0.5f) * 3.0f;
+        triVal += 3.0f * phaseDelta * (PolyBLEP::blamp(t2, phaseDelta) - PolyBLEP::blamp(ph, phaseDelta));
+        
+        return triVal;
+    }
+    
+    // -------- SNAPSHOT -------- //
+    void writeSnapshot(SnapshotWriter& writer) // where the oscillator is, see snapshot.h
+    {
+        writer.write(phase);
+        writer.write(frequency);
+        writer.write(phaseDelta);
+    }
+    
+    void readSnapshot(SnapshotReader& reader)
+    {
+        reader.read(phase);
+        reader.read(frequency);
+        reader.read(phaseDelta);
+    }
+    
 private:
     float phase = 0.0f;
-    float frequency;
-    float sampleRate;
-    float phaseDelta;
+    float frequency = 0.0f;
+    float sampleRate = 44100.0f;
+    float phaseDelta = 0.0f;
     float pulseWidth;
+    SineMode sineMode = SineMode::precise;
+    bool bandLimited = false;
 };
 
 
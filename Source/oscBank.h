@@ -0,0 +1,377 @@
+/*
+  ==============================================================================
+
+    oscBank.h
+    Created: 16 Oct 2026 11:02:15am
+    Author:  Christopher Duvall
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "osc.h"
+
+/**
+ A whole vector of Oscillators stored side by side (structure of arrays) instead of one object per voice.
+ Phase, phase delta, pulse width and wave type live in their own contiguous arrays,
+ so one sample of every voice is rendered with SIMD registers (as many voices at a time as a register holds,
+ 4 with JUCE's SSE / NEON registers).
+
+ Wave types are the same as Oscillator: square, sine and triangle, chosen per voice.
+ Every voice renders all three shapes and keeps the one it needs, which removes the j % 3 branching.
+ Output matches Oscillator::squareWave(), sineWave() and triWave() to within float rounding
+ (the sine polynomial is accurate to about 2e-7, -133 dB), drone_golden --check holds it to -100 dB.
+
+ Square and triangle voices can be band limited (PolyBLEP / PolyBLAMP, see osc.h) with setBandLimited().
+
+ Works as a fixed size voice pool: storage is allocated once by setCapacity() (from prepareToPlay),
+ voices are then switched on and off with activate() / deactivate(), which ramp the voice level
+ instead of creating or destroying anything. Nothing here allocates on the audio thread.
+
+ IMPORTANT: same as Oscillator, always set sample rate BEFORE setting frequencies.
+*/
+
+class OscillatorBank
+{
+public:
+    using SIMD = juce::dsp::SIMDRegister<float>;
+
+    enum WaveType
+    {
+        square = 0,
+        sine,
+        triangle
+    };
+
+    // -------- SETTERS -------- //
+
+    // allocates room for numVoices voices (rounded up to whole SIMD registers)
+    // only reallocates when the capacity changes, never call from the audio thread
+    void setCapacity(int numVoices)
+    {
+        int simdSize = (int)SIMD::size();
+        int padded = ((juce::jmax(1, numVoices) + simdSize - 1) / simdSize) * simdSize;
+
+        if (padded == capacity)
+            return;
+
+        capacity = padded;
+
+        // one block for every array, with room to line the first one up for SIMD loads
+        storage.allocate((size_t)(capacity * numArrays + alignment), true);
+        float* base = juce::snapPointerToAlignment(storage.getData(), (size_t)alignment * sizeof(float));
+
+        phase = base;
+        phaseDelta = phase + capacity;
+        pulseWidth = phaseDelta + capacity;
+        squareMask = pulseWidth + capacity;
+        sineMask = squareMask + capacity;
+        triMask = sineMask + capacity;
+        level = triMask + capacity;
+        levelStep = level + capacity;
+        output = levelStep + capacity;
+        blepMask = output + capacity;
+
+        for (int i = 0; i < capacity; i++)
+        {
+            pulseWidth[i] = 0.5f;
+            setWaveType(i, sine);
+        }
+    }
+
+    void setSampleRate(float SR) // sample rate for all voices, every voice keeps its frequency
+    {
+        float ratio = sampleRate / SR;
+        sampleRate = SR;
+
+        for (int i = 0; i < capacity; i++)
+        {
+            phaseDelta[i] *= ratio;
+            levelStep[i] *= ratio; // ramps keep their length in seconds
+        }
+    }
+
+    void setFreq(int voice, float freq) // frequency and phase delta
+    {
+        phaseDelta[voice] = freq / sampleRate;
+    }
+
+    // phase deltas (frequency / sample rate) for the first numVoices voices, straight from an array
+    // for per sample modulation, a plain copy, no frequency / sample rate or 1 / delta for each voice
+    // deltas must be positive
+    void setPhaseDeltas(const float* deltas, int numVoices)
+    {
+        std::copy(deltas, deltas + numVoices, phaseDelta);
+    }
+
+    void setBandLimited(int voice, bool shouldBeBandLimited) // PolyBLEP square and triangle waves
+    {
+        blepMask[voice] = shouldBeBandLimited ? 1.0f : 0.0f;
+    }
+
+    void setPulseWidth(int voice, float pw) // pulse width for square waves
+    {
+        pulseWidth[voice] = pw;
+    }
+
+    void setWaveType(int voice, WaveType type) // which shape this voice outputs
+    {
+        squareMask[voice] = type == square ? 1.0f : 0.0f;
+        sineMask[voice] = type == sine ? 1.0f : 0.0f;
+        triMask[voice] = type == triangle ? 1.0f : 0.0f;
+    }
+
+    void resetPhase(int voice) // set phase back to 0
+    {
+        phase[voice] = 0.0f;
+    }
+
+    void setPhase(int voice, float newPhase) // 0 - 1, for restoring a saved state
+    {
+        phase[voice] = newPhase;
+    }
+
+    // switch a voice on, fading in over rampSamples (0 = straight on)
+    // a silent voice starts from phase 0, like a newly constructed Oscillator
+    void activate(int voice, int rampSamples)
+    {
+        if (level[voice] <= 0.0f)
+            resetPhase(voice);
+
+        if (rampSamples <= 0)
+        {
+            level[voice] = 1.0f;
+            levelStep[voice] = 0.0f;
+        }
+        else
+            levelStep[voice] = 1.0f / (float)rampSamples;
+    }
+
+    // switch a voice off, fading out over rampSamples (0 = straight off)
+    void deactivate(int voice, int rampSamples)
+    {
+        if (rampSamples <= 0)
+        {
+            level[voice] = 0.0f;
+            levelStep[voice] = 0.0f;
+        }
+        else
+            levelStep[voice] = -1.0f / (float)rampSamples;
+    }
+
+    // -------- GETTERS -------- //
+    int getCapacity()
+    {
+        return capacity;
+    }
+
+    float getSampleRate()
+    {
+        return sampleRate;
+    }
+
+    float getFreq(int voice)
+    {
+        return phaseDelta[voice] * sampleRate;
+    }
+
+    float getPhase(int voice) // 0 - 1
+    {
+        return phase[voice];
+    }
+
+    bool isActive(int voice) // still making sound, or fading in
+    {
+        return level[voice] > 0.0f || levelStep[voice] > 0.0f;
+    }
+
+    const float* getLevels() // level of each voice after the last process() call
+    {
+        return level;
+    }
+
+    // -------- SEEKING -------- //
+    // jumps the first numVoices voices numSamples samples ahead at their current phase deltas, without rendering
+    // on / off ramps jump ahead too
+    void skip(int numVoices, int numSamples)
+    {
+        for (int i = 0; i < numVoices; i++)
+        {
+            double ph = phase[i] + (double)phaseDelta[i] * numSamples;
+            phase[i] = (float)(ph - std::floor(ph));
+            level[i] = juce::jlimit(0.0f, 1.0f, level[i] + levelStep[i] * (float)numSamples);
+        }
+    }
+
+    // -------- SNAPSHOT -------- //
+    // every voice's arrays, straight out of storage, see snapshot.h
+    // reads back into a bank with the same capacity
+    void writeSnapshot(SnapshotWriter& writer)
+    {
+        writer.writeArray(phase, capacity * numArrays);
+    }
+
+    void readSnapshot(SnapshotReader& reader)
+    {
+        reader.readArray(phase, capacity * numArrays);
+    }
+
+    // -------- PROCESS -------- //
+    // advances the first numVoices voices by one sample
+    // returns each voice's output (already scaled by voice level), one float per voice
+    const float* process(int numVoices)
+    {
+        const auto zero = SIMD::expand(0.0f);
+        const auto one = SIMD::expand(1.0f);
+        const auto half = SIMD::expand(0.5f);
+        const auto three = SIMD::expand(3.0f);
+
+        for (int i = 0; i < numVoices; i += (int)SIMD::size())
+        {
+            // phasor
+            auto ph = SIMD::fromRawArray(phase + i) + SIMD::fromRawArray(phaseDelta + i);
+            ph = ph - (one & SIMD::greaterThan(ph, one));
+            ph.copyToRawArray(phase + i);
+
+            auto pw = SIMD::fromRawArray(pulseWidth + i);
+            auto dt = SIMD::fromRawArray(phaseDelta + i);
+            auto invDt = reciprocal(dt);
+            auto bl = SIMD::fromRawArray(blepMask + i);
+
+            // square wave, 0.5 until pulse width then -0.5
+            auto squareVal = half - (one & SIMD::greaterThan(ph, pw));
+
+            // band limited square, jumps up at phase 0 and down at pulse width
+            auto t2 = ph - pw;
+            t2 = t2 + (one & SIMD::lessThan(t2, zero));
+            auto squareBL = half - (one & SIMD::greaterThanOrEqual(ph, pw))
+                          + half * (polyBlep(ph, dt, invDt) - polyBlep(t2, dt, invDt));
+            squareVal = squareVal + bl * (squareBL - squareVal);
+
+            // triangle wave
+            auto triVal = (SIMD::abs(ph - half) - half) * three;
+
+            // band limited triangle, slope changes by -6 at phase 0 and +6 at phase 0.5
+            auto t3 = ph + half;
+            t3 = t3 - (one & SIMD::greaterThanOrEqual(t3, one));
+            triVal = triVal + bl * three * dt * (polyBlamp(t3, dt, invDt) - polyBlamp(ph, dt, invDt));
+
+            // sine wave
+            auto sineVal = sineTurns(ph);
+
+            // keep the shape each voice is set to
+            auto outVal = squareVal * SIMD::fromRawArray(squareMask + i)
+                        + sineVal * SIMD::fromRawArray(sineMask + i)
+                        + triVal * SIMD::fromRawArray(triMask + i);
+
+            // voice on / off ramps
+            auto lv = SIMD::min(one, SIMD::max(zero, SIMD::fromRawArray(level + i) + SIMD::fromRawArray(levelStep + i)));
+            lv.copyToRawArray(level + i);
+
+            (outVal * lv).copyToRawArray(output + i);
+        }
+
+        return output;
+    }
+
+    // -------- HELPERS -------- //
+    // 1 / x for PolyBLEP (and ChaseSwarm's distortion), SIMD registers can't divide
+    // hardware estimate sharpened with Newton steps (x' = x (2 - a x)) to about float precision,
+    // plain divides where JUCE has no native registers
+    // 0 gives inf or NaN, only ever used where polyBlep() / polyBlamp() mask it off
+    static SIMD reciprocal(SIMD x)
+    {
+        const auto two = SIMD::expand(2.0f);
+        SIMD r;
+
+       #if JUCE_USE_SSE_INTRINSICS
+        r.value = _mm_rcp_ps(x.value); // 12 bits
+        r = r * (two - x * r);
+       #elif JUCE_USE_ARM_NEON
+        r.value = vrecpeq_f32(x.value); // 8 bits
+        r = r * (two - x * r);
+        r = r * (two - x * r);
+       #else
+        for (size_t k = 0; k < SIMD::size(); k++)
+            r.set(k, 1.0f / x.get(k));
+       #endif
+
+        return r;
+    }
+
+private:
+    // SIMD versions of PolyBLEP::blep and PolyBLEP::blamp
+    static SIMD polyBlep(SIMD t, SIMD dt, SIMD invDt)
+    {
+        const auto one = SIMD::expand(1.0f);
+
+        auto after = SIMD::lessThan(t, dt);
+        auto before = SIMD::greaterThan(t, one - dt);
+
+        auto x1 = t * invDt;
+        auto x2 = (t - one) * invDt;
+
+        return ((x1 + x1 - x1 * x1 - one) & after) + ((x2 * x2 + x2 + x2 + one) & before);
+    }
+
+    static SIMD polyBlamp(SIMD t, SIMD dt, SIMD invDt)
+    {
+        const auto one = SIMD::expand(1.0f);
+        const auto third = SIMD::expand(1.0f / 3.0f);
+
+        auto after = SIMD::lessThan(t, dt);
+        auto before = SIMD::greaterThan(t, one - dt);
+
+        auto x1 = t * invDt - one;
+        auto x2 = (t - one) * invDt + one;
+
+        return ((SIMD::expand(0.0f) - x1 * x1 * x1 * third) & after) + ((x2 * x2 * x2 * third) & before);
+    }
+
+    // sin(2 * pi * ph) for ph in 0 - 1
+    // folds phase into a quarter cycle, then 9th order minimax polynomial (max error about 2e-7, float rounding)
+    static SIMD sineTurns(SIMD ph)
+    {
+        const auto half = SIMD::expand(0.5f);
+        const auto quarter = SIMD::expand(0.25f);
+
+        // sin(2pi ph) = -sin(2pi t), t in -0.5 - 0.5
+        auto t = ph - half;
+
+        // fold into -0.25 - 0.25
+        auto above = SIMD::greaterThan(t, quarter);
+        auto below = SIMD::lessThan(t, SIMD::expand(-0.25f));
+        auto keep = ~(above | below);
+        t = ((half - t) & above) + ((SIMD::expand(-0.5f) - t) & below) + (t & keep);
+
+        auto t2 = t * t;
+        auto poly = SIMD::expand(3.987340714e+01f);
+        poly = poly * t2 + SIMD::expand(-7.659823234e+01f);
+        poly = poly * t2 + SIMD::expand(8.160326684e+01f);
+        poly = poly * t2 + SIMD::expand(-4.134169188e+01f);
+        poly = poly * t2 + SIMD::expand(6.283185302e+00f);
+
+        return SIMD::expand(0.0f) - poly * t;
+    }
+
+    static constexpr int numArrays = 10; // float arrays that live in storage
+    static constexpr int alignment = (int)(SIMD::SIMDRegisterSize / sizeof(float)); // floats, one whole register, so SIMD loads line up
+
+    float sampleRate = 44100.0f;
+    int capacity = 0;
+
+    // voice data, one slot per voice, all carved out of storage
+    juce::HeapBlock<float> storage;
+    float* phase = nullptr;
+    float* phaseDelta = nullptr;
+    float* pulseWidth = nullptr;
+    float* squareMask = nullptr;
+    float* sineMask = nullptr;
+    float* triMask = nullptr;
+    float* level = nullptr; // voice on / off level, 0 - 1
+    float* levelStep = nullptr; // per sample change in level while ramping
+    float* output = nullptr; // last rendered sample of each voice
+    float* blepMask = nullptr; // 1 for band limited voices, 0 for naive
+};
@@ -0,0 +1,69 @@
+/*
+  ==============================================================================
+
+    randomSource.h
+    Created: 16 Oct 2026 4:21:33pm
+    Author:  Christopher Duvall
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ One seed for the whole piece.
+ Every part of the drone that needs random numbers gets its own stream, seeded from the piece seed and a stream id.
+ Streams are independent, so extra random calls in one synth never shift the numbers another synth sees.
+
+ Same seed + same sample rate = bit identical output, whatever the block size.
+ Stream seeds are mixed with splitmix64, so neighbouring seeds (1, 2, 3...) still give unrelated streams.
+*/
+
+class RandomSource
+{
+public:
+    // one id per subsystem, add new ones at the end so existing streams keep their numbers
+    enum Stream
+    {
+        thickSynthStream = 1,
+        chasingSynthStream,
+        thickSynthNoiseStream,
+        chaseSwarmStream
+    };
+
+    // -------- CONSTRUCTOR -------- //
+    RandomSource() {};
+    RandomSource(juce::int64 startSeed) : seed(startSeed) {};
+
+    // -------- SETTERS -------- //
+    void setSeed(juce::int64 newSeed) // piece seed
+    {
+        seed = newSeed;
+    }
+
+    // -------- GETTERS -------- //
+    juce::int64 getSeed()
+    {
+        return seed;
+    }
+
+    // seed for one subsystem's juce::Random
+    juce::int64 getStreamSeed(int stream)
+    {
+        return (juce::int64)splitMix((juce::uint64)seed + (juce::uint64)stream * 0x9e3779b97f4a7c15ULL);
+    }
+
+private:
+    // splitmix64 finaliser (Steele, Lea, Flood), spreads every input bit over the whole output
+    static juce::uint64 splitMix(juce::uint64 x)
+    {
+        x += 0x9e3779b97f4a7c15ULL;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+    juce::int64 seed = 1;
+};
@@ -0,0 +1,246 @@
+/*
+  ==============================================================================
+
+    snapshot.h
+    Created: 16 Oct 2026 11:24:05pm
+    Author:  Christopher Duvall
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ Binary snapshots of everything in the drone that changes as it plays, so a session can carry on exactly where it was.
+
+ Every class with evolving state has writeSnapshot() / readSnapshot(), which go through its members in a fixed order.
+ Values are copied as raw bytes, so floats come back bit for bit and a restored drone renders the same samples
+ the saved one would have. Sizes aren't stored, snapshots only go back into a drone prepared the same way
+ (the processor checks that first, see Drone_pieceAudioProcessor::readSnapshot).
+
+ SnapshotWriter and SnapshotReader work on memory that's already there and never allocate, so they're fine on the audio thread.
+ A SnapshotWriter without any memory just counts bytes, for sizing buffers in prepareToPlay.
+*/
+
+class SnapshotWriter
+{
+public:
+    // -------- CONSTRUCTOR -------- //
+    SnapshotWriter() {}; // counts bytes only
+    SnapshotWriter(void* dest, size_t destSize) : data(static_cast<char*>(dest)), capacity(destSize) {};
+
+    // -------- METHODS -------- //
+    template <typename T>
+    void write(T value)
+    {
+        writeArray(&value, 1);
+    }
+
+    template <typename T>
+    void writeArray(const T* values, int count)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshots only hold plain values");
+
+        size_t bytes = sizeof(T) * (size_t)juce::jmax(0, count);
+
+        if (data != nullptr)
+        {
+            if (overflow || size + bytes > capacity)
+            {
+                overflow = true;
+                return;
+            }
+
+            std::memcpy(data + size, values, bytes);
+        }
+
+        size += bytes;
+    }
+
+    // where it is and where it's going, a glide carries on from here over its full length
+    void writeSmoothed(juce::SmoothedValue<float>& value)
+    {
+        write(value.getCurrentValue());
+        write(value.getTargetValue());
+    }
+
+    // -------- GETTERS -------- //
+    size_t getSize() const // bytes written (or counted) so far
+    {
+        return size;
+    }
+
+    bool failed() const // ran out of room
+    {
+        return overflow;
+    }
+
+private:
+    char* data = nullptr;
+    size_t capacity = 0;
+    size_t size = 0;
+    bool overflow = false;
+};
+
+
+class SnapshotReader
+{
+public:
+    // -------- CONSTRUCTOR -------- //
+    SnapshotReader(const void* source, size_t sourceSize) : data(static_cast<const char*>(source)), capacity(sourceSize) {};
+
+    // -------- METHODS -------- //
+    template <typename T>
+    void read(T& value)
+    {
+        readArray(&value, 1);
+    }
+
+    template <typename T>
+    void readArray(T* values, int count)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshots only hold plain values");
+
+        size_t bytes = sizeof(T) * (size_t)juce::jmax(0, count);
+
+        if (overflow || position + bytes > capacity)
+        {
+            overflow = true;
+            return;
+        }
+
+        std::memcpy(values, data + position, bytes);
+        position += bytes;
+    }
+
+    void readSmoothed(juce::SmoothedValue<float>& value)
+    {
+        float current = value.getCurrentValue(), target = value.getTargetValue();
+        read(current);
+        read(target);
+
+        value.setCurrentAndTargetValue(current);
+        value.setTargetValue(target);
+    }
+
+    // -------- GETTERS -------- //
+    size_t getPosition() const // bytes read so far
+    {
+        return position;
+    }
+
+    bool failed() const // tried to read past the end
+    {
+        return overflow;
+    }
+
+private:
+    const char* data;
+    size_t capacity;
+    size_t position = 0;
+    bool overflow = false;
+};
+
+
+/**
+ Two snapshot slots, so the audio thread can write a new snapshot while the last finished one is still being copied out.
+
+ A background thread calls takeSnapshot(), which raises a request and waits. The audio thread checks isRequested()
+ at the end of a block, writes into the free slot (startWriting() / finishWriting()) and publishes it.
+ The audio thread only touches atomics and its own slot, it never waits. Background callers queue up behind each other.
+*/
+
+class SnapshotBuffer
+{
+public:
+    // -------- SETTERS -------- //
+
+    // room for snapshots up to slotSize bytes, never call while the audio thread is using the buffer
+    // memory is only allocated by the first takeSnapshot(), drones nobody snapshots don't pay for it
+    void setSlotSize(size_t slotSize)
+    {
+        const juce::ScopedLock sl (readerLock);
+
+        slotBytes = slotSize;
+        storage.free();
+        slotSizes[0] = slotSizes[1] = 0;
+        writeSlot = 0;
+        published.store(-1);
+        requested.store(false);
+    }
+
+    // -------- BACKGROUND THREAD -------- //
+
+    // asks the audio thread for a snapshot and copies it into dest once it's written
+    // false if no block came along within timeoutMs (the audio thread isn't running)
+    bool takeSnapshot(juce::MemoryBlock& dest, int timeoutMs)
+    {
+        const juce::ScopedLock sl (readerLock);
+
+        // no request has gone out since setSlotSize(), so the audio thread can't be writing
+        if (storage.getData() == nullptr)
+            storage.allocate(slotBytes * 2, true);
+
+        auto before = count.load(std::memory_order_acquire);
+        requested.store(true, std::memory_order_release);
+
+        auto start = juce::Time::getMillisecondCounter();
+
+        while (count.load(std::memory_order_acquire) == before)
+        {
+            if (juce::Time::getMillisecondCounter() - start > (juce::uint32)timeoutMs)
+                return false;
+
+            juce::Thread::sleep(1);
+        }
+
+        int slot = published.load(std::memory_order_acquire);
+
+        if (slot < 0)
+            return false;
+
+        // the audio thread won't come back to this slot until the next request
+        dest.replaceWith(storage.getData() + (size_t)slot * slotBytes, slotSizes[slot]);
+        return true;
+    }
+
+    // -------- AUDIO THREAD -------- //
+    bool isRequested()
+    {
+        return requested.load(std::memory_order_acquire);
+    }
+
+    SnapshotWriter startWriting()
+    {
+        return SnapshotWriter(storage.getData() + (size_t)writeSlot * slotBytes, slotBytes);
+    }
+
+    void finishWriting(const SnapshotWriter& writer)
+    {
+        if (! writer.failed())
+        {
+            slotSizes[writeSlot] = writer.getSize();
+            published.store(writeSlot, std::memory_order_release);
+            writeSlot ^= 1;
+        }
+        else
+            published.store(-1, std::memory_order_release); // didn't fit, nothing up to date to hand out
+
+        requested.store(false, std::memory_order_release);
+        count.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+private:
+    juce::HeapBlock<char> storage; // both slots, back to back
+    size_t slotBytes = 0;
+    size_t slotSizes[2] = {};
+    int writeSlot = 0; // audio thread only
+
+    std::atomic<int> published { -1 }; // last finished slot
+    std::atomic<bool> requested { false };
+    std::atomic<juce::uint32> count { 0 }; // snapshots finished (or given up on) so far
+
+    juce::CriticalSection readerLock; // background callers only, one request at a time
+};
@@ -0,0 +1,394 @@
+/*
+  ==============================================================================
+
+    spatialPanner.h
+    Created: 16 Oct 2026 8:36:02pm
+    Author:  Christopher Duvall
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "snapshot.h"
+
+/**
+ Places a mono source in stereo, surround speaker rings or ambisonic B-format, so the chase synth can spin around the room.
+
+ Position is the chase synth's pan value: 1 = left, 0 = right, and it swings past both ends (-1 - 2).
+ Stereo keeps the original linear pan (left = position, right = 1 - position).
+ Everywhere else the position becomes an azimuth, (position - 0.5) * 120 degrees, so 0 - 1 covers
+ the stereo speakers and the whole swing goes all the way round (+ is left, anticlockwise).
+
+ Speaker layouts (quad, 5.1, 7.1, 8 speaker ring) use pairwise constant power panning between the two
+ nearest speakers, LFE is left out. Ambisonics is ACN channel order with SN3D normalisation (AmbiX), 1st or 3rd order.
+
+ Gains are worked out on each setPosition() and ramped over the next setRampLength() samples, one gain per channel.
+ Ramp gains come from the sample's place in the ramp, so splitting a ramp over several addPanned() calls
+ gives exactly the same output. Channels that are silent at both ends of the ramp are skipped, so on speaker layouts only the
+ two or three speakers near the source cost anything per sample, however many channels there are.
+*/
+
+class SpatialPanner
+{
+public:
+    enum Layout
+    {
+        mono = 0,
+        stereo,
+        quad,
+        surround51,
+        surround71,
+        ring8,
+        ambisonic1,
+        ambisonic3
+    };
+
+    static constexpr int maxChannels = 16; // 3rd order ambisonics
+
+    // -------- SETTERS -------- //
+
+    // picks the layout matching an output bus, false (and stereo) if it isn't one of ours
+    bool setChannelSet(const juce::AudioChannelSet& set)
+    {
+        Layout newLayout;
+
+        if (! layoutFor(set, newLayout))
+        {
+            setChannelSet(juce::AudioChannelSet::stereo());
+            return false;
+        }
+
+        layout = newLayout;
+        numChannels = channelsFor(layout);
+
+        // speaker positions come from the channel types, so channel order doesn't matter
+        for (int ch = 0; ch < maxChannels; ch++)
+        {
+            speakerAzimuth[ch] = (ch < numChannels && ! isAmbisonic()) ? azimuthOf(set.getTypeOfChannel(ch)) : lfe;
+            current[ch] = 0.0f;
+            target[ch] = 0.0f;
+        }
+
+        firstBlock = true;
+        rampPosition = 0;
+        return true;
+    }
+
+    void setLayout(Layout newLayout)
+    {
+        setChannelSet(channelSetFor(newLayout));
+    }
+
+    void setRampLength(int numSamples) // samples to glide from one position to the next
+    {
+        rampLength = juce::jmax(1, numSamples);
+    }
+
+    // where the source glides to over the next ramp, see class notes
+    void setPosition(float position)
+    {
+        // start from wherever the last ramp got to
+        if (rampPosition >= rampLength)
+            std::copy(target, target + maxChannels, current);
+        else
+            for (int ch = 0; ch < maxChannels; ch++)
+                current[ch] += (target[ch] - current[ch]) * (float)rampPosition / (float)rampLength;
+
+        rampPosition = 0;
+
+        if (layout == stereo)
+        {
+            target[0] = position;
+            target[1] = 1.0f - position;
+        }
+        else if (layout == mono)
+        {
+            target[0] = 1.0f; // left + right
+        }
+        else
+        {
+            float azimuth = (position - 0.5f) * juce::MathConstants<float>::twoPi / 3.0f;
+
+            if (isAmbisonic())
+                encodeAmbisonic(azimuth);
+            else
+                panSpeakers(azimuth);
+        }
+
+        // nothing to ramp from the very first time
+        if (firstBlock)
+        {
+            std::copy(target, target + maxChannels, current);
+            firstBlock = false;
+        }
+    }
+
+    // -------- GETTERS -------- //
+    Layout getLayout()
+    {
+        return layout;
+    }
+
+    int getNumChannels()
+    {
+        return numChannels;
+    }
+
+    bool isAmbisonic()
+    {
+        return layout == ambisonic1 || layout == ambisonic3;
+    }
+
+    bool isSpeaker(int channel) // false for LFE, every ambisonic channel counts
+    {
+        return channel < numChannels && (isAmbisonic() || speakerAzimuth[channel] != lfe);
+    }
+
+    // -------- SNAPSHOT -------- //
+    void writeSnapshot(SnapshotWriter& writer) // gains and how far through the ramp, see snapshot.h
+    {
+        writer.writeArray(current, maxChannels);
+        writer.writeArray(target, maxChannels);
+        writer.write(rampPosition);
+        writer.write(firstBlock);
+    }
+
+    void readSnapshot(SnapshotReader& reader)
+    {
+        reader.readArray(current, maxChannels);
+        reader.readArray(target, maxChannels);
+        reader.read(rampPosition);
+        reader.read(firstBlock);
+    }
+
+    // -------- PROCESS -------- //
+
+    // adds the source to out, carrying on the ramp from the last position to the current one
+    void addPanned(const float* source, juce::AudioBuffer<float>& out, int startSample, int numSamples, float gain)
+    {
+        int channels = juce::jmin(numChannels, out.getNumChannels());
+        int ramping = juce::jlimit(0, numSamples, rampLength - rampPosition); // samples still on the ramp
+
+        for (int ch = 0; ch < channels; ch++)
+        {
+            if (current[ch] == 0.0f && target[ch] == 0.0f)
+                continue; // speaker nowhere near the source
+
+            float* dest = out.getWritePointer(ch, startSample);
+            float step = (target[ch] - current[ch]) / (float)rampLength;
+
+            for (int i = 0; i < ramping; i++)
+                dest[i] += source[i] * gain * (current[ch] + step * (float)(rampPosition + i));
+
+            for (int i = ramping; i < numSamples; i++)
+                dest[i] += source[i] * gain * target[ch];
+        }
+
+        rampPosition += ramping;
+    }
+
+    // adds a source that comes from everywhere (the thick synth)
+    // stereo and mono keep full gain on every channel, speakers share the power, ambisonics only uses W
+    void addOmni(const float* source, juce::AudioBuffer<float>& out, int startSample, int numSamples, float gain)
+    {
+        int channels = juce::jmin(numChannels, out.getNumChannels());
+
+        if (isAmbisonic())
+        {
+            out.addFrom(0, startSample, source, numSamples, gain);
+            return;
+        }
+
+        int speakers = 0;
+        for (int ch = 0; ch < channels; ch++)
+            if (speakerAzimuth[ch] != lfe)
+                speakers++;
+
+        // same power as the stereo mix, however many speakers
+        float speakerGain = speakers <= 2 ? gain : gain * std::sqrt(2.0f / (float)speakers);
+
+        for (int ch = 0; ch < channels; ch++)
+            if (speakerAzimuth[ch] != lfe)
+                out.addFrom(ch, startSample, source, numSamples, speakerGain);
+    }
+
+    // -------- LAYOUTS -------- //
+    static int channelsFor(Layout l)
+    {
+        switch (l)
+        {
+            case mono:       return 1;
+            case stereo:     return 2;
+            case quad:       return 4;
+            case surround51: return 6;
+            case surround71: return 8;
+            case ring8:      return 8;
+            case ambisonic1: return 4;
+            case ambisonic3: return 16;
+            default:         return 2;
+        }
+    }
+
+    static juce::AudioChannelSet channelSetFor(Layout l)
+    {
+        switch (l)
+        {
+            case mono:       return juce::AudioChannelSet::mono();
+            case quad:       return juce::AudioChannelSet::quadraphonic();
+            case surround51: return juce::AudioChannelSet::create5point1();
+            case surround71: return juce::AudioChannelSet::create7point1();
+            case ring8:      return juce::AudioChannelSet::octagonal();
+            case ambisonic1: return juce::AudioChannelSet::ambisonic(1);
+            case ambisonic3: return juce::AudioChannelSet::ambisonic(3);
+            case stereo:
+            default:         return juce::AudioChannelSet::stereo();
+        }
+    }
+
+    // the layout for an output bus, false if we can't pan into it
+    static bool layoutFor(const juce::AudioChannelSet& set, Layout& result)
+    {
+        if (set == juce::AudioChannelSet::mono())               result = mono;
+        else if (set == juce::AudioChannelSet::stereo())        result = stereo;
+        else if (set == juce::AudioChannelSet::quadraphonic())  result = quad;
+        else if (set == juce::AudioChannelSet::create5point1()) result = surround51;
+        else if (set == juce::AudioChannelSet::create7point1()) result = surround71;
+        else if (set == juce::AudioChannelSet::octagonal())     result = ring8;
+        else if (set == juce::AudioChannelSet::ambisonic(1))    result = ambisonic1;
+        else if (set == juce::AudioChannelSet::ambisonic(3))    result = ambisonic3;
+        else
+            return false;
+
+        return true;
+    }
+
+private:
+    // ---- SPEAKERS ---- //
+
+    // azimuth of a speaker from its channel type, ring layouts put wide speakers at the sides
+    float azimuthOf(juce::AudioChannelSet::ChannelType type)
+    {
+        const float deg = juce::MathConstants<float>::pi / 180.0f;
+        bool evenRing = layout == quad || layout == ring8; // speakers every 90 or 45 degrees
+        bool ring = layout == ring8;
+
+        switch (type)
+        {
+            case juce::AudioChannelSet::left:              return (evenRing ? 45.0f : 30.0f) * deg;
+            case juce::AudioChannelSet::right:             return (evenRing ? -45.0f : -30.0f) * deg;
+            case juce::AudioChannelSet::centre:            return 0.0f;
+            case juce::AudioChannelSet::wideLeft:          return (ring ? 90.0f : 60.0f) * deg;
+            case juce::AudioChannelSet::wideRight:         return (ring ? -90.0f : -60.0f) * deg;
+            case juce::AudioChannelSet::leftSurround:      return (evenRing ? 135.0f : 110.0f) * deg;
+            case juce::AudioChannelSet::rightSurround:     return (evenRing ? -135.0f : -110.0f) * deg;
+            case juce::AudioChannelSet::leftSurroundSide:  return 90.0f * deg;
+            case juce::AudioChannelSet::rightSurroundSide: return -90.0f * deg;
+            case juce::AudioChannelSet::leftSurroundRear:  return 150.0f * deg;
+            case juce::AudioChannelSet::rightSurroundRear: return -150.0f * deg;
+            case juce::AudioChannelSet::centreSurround:    return 180.0f * deg;
+            default:                                       return lfe; // LFE and anything unknown stays silent
+        }
+    }
+
+    // constant power between the two speakers either side of azimuth
+    void panSpeakers(float azimuth)
+    {
+        int below = -1, above = -1; // nearest speaker clockwise / anticlockwise of the source
+        float belowDist = 10.0f, aboveDist = 10.0f;
+
+        for (int ch = 0; ch < numChannels; ch++)
+        {
+            target[ch] = 0.0f;
+
+            if (speakerAzimuth[ch] == lfe)
+                continue;
+
+            float anticlockwise = wrapAngle(speakerAzimuth[ch] - azimuth);
+            float clockwise = wrapAngle(azimuth - speakerAzimuth[ch]);
+
+            if (anticlockwise < aboveDist)
+            {
+                aboveDist = anticlockwise;
+                above = ch;
+            }
+
+            if (clockwise < belowDist)
+            {
+                belowDist = clockwise;
+                below = ch;
+            }
+        }
+
+        if (above < 0)
+            return;
+
+        float span = aboveDist + belowDist;
+        float t = span > 0.0f ? belowDist / span : 0.0f; // 0 at the lower speaker, 1 at the upper one
+
+        target[below] = std::cos(t * juce::MathConstants<float>::halfPi);
+        target[above] += std::sin(t * juce::MathConstants<float>::halfPi);
+    }
+
+    static float wrapAngle(float angle) // 0 - 2pi
+    {
+        const float twoPi = juce::MathConstants<float>::twoPi;
+        return angle - twoPi * std::floor(angle / twoPi);
+    }
+
+    // ---- AMBISONICS ---- //
+
+    // real spherical harmonics on the horizon, ACN order, SN3D
+    void encodeAmbisonic(float azimuth)
+    {
+        int order = layout == ambisonic3 ? 3 : 1;
+
+        for (int l = 0; l <= order; l++)
+        {
+            for (int m = -l; m <= l; m++)
+            {
+                int acn = l * l + l + m;
+                float angular = m >= 0 ? std::cos((float)m * azimuth) : std::sin((float)-m * azimuth);
+                target[acn] = horizonWeight(l, std::abs(m)) * angular;
+            }
+        }
+    }
+
+    // SN3D normalised associated Legendre function at elevation 0, P(l, m) of sin(0)
+    static float horizonWeight(int l, int m)
+    {
+        // P(l, m)(0) is 0 when l + m is odd
+        if ((l + m) % 2 != 0)
+            return 0.0f;
+
+        // P(l, m)(0) = (-1)^((l - m) / 2) (l + m - 1)!! / (l - m)!!, no Condon-Shortley phase
+        double p = ((l - m) / 2) % 2 == 0 ? 1.0 : -1.0;
+
+        for (int k = l + m - 1; k > 1; k -= 2)
+            p *= k;
+
+        for (int k = l - m; k > 1; k -= 2)
+            p /= k;
+
+        // SN3D: sqrt((2 - delta(m)) (l - m)! / (l + m)!)
+        double norm = m == 0 ? 1.0 : 2.0;
+
+        for (int k = l - m + 1; k <= l + m; k++)
+            norm /= k;
+
+        return (float)(std::sqrt(norm) * p);
+    }
+
+    static constexpr float lfe = 1000.0f; // marks a channel that never gets panned into
+
+    Layout layout = stereo;
+    int numChannels = 2;
+    bool firstBlock = true;
+    int rampLength = 1; // samples per glide
+    int rampPosition = 0; // samples into the current glide
+
+    float speakerAzimuth[maxChannels]; // radians, lfe for no speaker
+    float current[maxChannels] = {}; // gains at the start of this block
+    float target[maxChannels] = {}; // gains at the end of this block
+};
@@ -0,0 +1,208 @@
+/*
+  ==============================================================================
+
+    stageProfiler.h
+    Created: 17 Oct 2026 11:03:18am
+    Author:  Christopher Duvall
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// 0 compiles the profiler down to nothing (see the "Release (no profiling)" configuration)
+#ifndef DRONE_PROFILING
+ #define DRONE_PROFILING 1
+#endif
+
+/**
+ Where processBlock's time goes, stage by stage, so a spiking instance can be pinned on the thick synth, the filter,
+ the chase synth or the reverb.
+
+ The audio thread times each stage with juce::Time::getHighResolutionTicks() (steady, a few ns to read), adds up
+ the laps for a block and files every stage's total in a histogram at the end of it.
+ Histograms are log spaced, bucketsPerOctave buckets for every doubling of time, so p99 is good to about 9%.
+ Everything is an atomic written only by the audio thread (plain loads and stores, no locked instructions),
+ any other thread can read stats at any time without stopping it.
+
+ With DRONE_PROFILING 0 every method is an empty inline, timing and all, and the optimiser removes the lot.
+*/
+
+class StageProfiler
+{
+public:
+    enum Stage
+    {
+        thickSynthStage = 0,
+        filterStage,
+        chaseSynthStage,
+        delayStage,
+        mixStage, // gains and panning
+        reverbStage,
+        blockStage, // the whole processBlock
+        numStages
+    };
+
+    struct Stats // microseconds per block
+    {
+        double min = 0.0;
+        double mean = 0.0;
+        double max = 0.0;
+        double p99 = 0.0;
+        juce::uint64 blocks = 0; // blocks timed since the last reset
+    };
+
+    static const char* getStageName(int stage)
+    {
+        static const char* names[] = { "thick synth", "filter", "chase synth", "catch delay", "gains + panning", "reverb", "whole block" };
+        return names[juce::jlimit(0, (int)numStages - 1, stage)];
+    }
+
+    static constexpr bool isEnabled()
+    {
+        return DRONE_PROFILING != 0;
+    }
+
+#if DRONE_PROFILING
+    StageProfiler()
+    {
+        nsPerTick = 1.0e9 / (double)juce::Time::getHighResolutionTicksPerSecond();
+        clear();
+    }
+
+    // -------- AUDIO THREAD -------- //
+    juce::int64 now()
+    {
+        return juce::Time::getHighResolutionTicks();
+    }
+
+    // adds the time since lapStart to stage, returns now for the next lap
+    juce::int64 lap(Stage stage, juce::int64 lapStart)
+    {
+        auto t = now();
+        blockTicks[stage] += t - lapStart;
+        return t;
+    }
+
+    // files this block's laps (whole block = blockStart to now), starts the next block from zero
+    void endBlock(juce::int64 blockStart)
+    {
+        blockTicks[blockStage] = now() - blockStart;
+
+        if (resetRequested.exchange(false, std::memory_order_acq_rel))
+            clear();
+
+        for (int s = 0; s < numStages; s++)
+        {
+            add(s, (juce::uint64)juce::jmax(0.0, (double)blockTicks[s] * nsPerTick));
+            blockTicks[s] = 0;
+        }
+    }
+
+    // -------- ANY THREAD -------- //
+    Stats getStats(int stage) const
+    {
+        Stats stats;
+        const auto& t = timings[juce::jlimit(0, (int)numStages - 1, stage)];
+
+        stats.blocks = t.count.load(std::memory_order_acquire);
+
+        if (stats.blocks == 0)
+            return stats;
+
+        stats.min = t.minNs.load(std::memory_order_relaxed) * 1.0e-3;
+        stats.max = t.maxNs.load(std::memory_order_relaxed) * 1.0e-3;
+        stats.mean = (double)t.totalNs.load(std::memory_order_relaxed) / (double)stats.blocks * 1.0e-3;
+
+        // first bucket with 99% of blocks at or under it, its top edge (never past the slowest block)
+        auto wanted = (juce::uint64)std::ceil(0.99 * (double)stats.blocks);
+        juce::uint64 seen = 0;
+
+        for (int b = 0; b < numBuckets; b++)
+        {
+            seen += t.buckets[b].load(std::memory_order_relaxed);
+
+            if (seen >= wanted)
+            {
+                stats.p99 = juce::jmin(stats.max, std::exp2((b + 1) / (double)bucketsPerOctave) * 1.0e-3);
+                break;
+            }
+        }
+
+        return stats;
+    }
+
+    // starts every histogram over, done by the audio thread at the end of its next block
+    void reset()
+    {
+        resetRequested.store(true, std::memory_order_release);
+    }
+
+private:
+    static constexpr int bucketsPerOctave = 8;
+    static constexpr int numBuckets = 36 * bucketsPerOctave; // 1 ns up to a minute
+
+    struct Timing
+    {
+        std::atomic<juce::uint64> count { 0 };
+        std::atomic<juce::uint64> totalNs { 0 };
+        std::atomic<juce::uint64> minNs { 0 };
+        std::atomic<juce::uint64> maxNs { 0 };
+        std::atomic<juce::uint32> buckets[numBuckets];
+    };
+
+    // audio thread only writes, so read, change, store is enough
+    template <typename T, typename V>
+    static void bump(std::atomic<T>& a, V amount)
+    {
+        a.store(a.load(std::memory_order_relaxed) + (T)amount, std::memory_order_relaxed);
+    }
+
+    void add(int stage, juce::uint64 ns)
+    {
+        auto& t = timings[stage];
+        auto count = t.count.load(std::memory_order_relaxed);
+
+        if (count == 0 || ns < t.minNs.load(std::memory_order_relaxed))
+            t.minNs.store(ns, std::memory_order_relaxed);
+
+        if (ns > t.maxNs.load(std::memory_order_relaxed))
+            t.maxNs.store(ns, std::memory_order_relaxed);
+
+        int bucket = ns == 0 ? 0 : (int)(std::log2((double)ns) * bucketsPerOctave);
+        bump(t.buckets[juce::jlimit(0, numBuckets - 1, bucket)], 1);
+        bump(t.totalNs, ns);
+
+        t.count.store(count + 1, std::memory_order_release); // readers see everything above once they see the count
+    }
+
+    void clear()
+    {
+        for (auto& t : timings)
+        {
+            t.count.store(0);
+            t.totalNs.store(0);
+            t.minNs.store(0);
+            t.maxNs.store(0);
+
+            for (auto& b : t.buckets)
+                b.store(0);
+        }
+    }
+
+    Timing timings[numStages];
+    juce::int64 blockTicks[numStages] = {}; // this block so far, audio thread only
+    double nsPerTick = 1.0;
+    std::atomic<bool> resetRequested { false };
+
+#else
+    // -------- COMPILED OUT -------- //
+    juce::int64 now() { return 0; }
+    juce::int64 lap(Stage, juce::int64) { return 0; }
+    void endBlock(juce::int64) {}
+    Stats getStats(int) const { return {}; }
+    void reset() {}
+#endif
+};
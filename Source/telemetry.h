@@ -0,0 +1,204 @@
+/*
+  ==============================================================================
+
+    telemetry.h
+    Created: 17 Oct 2026 2:41:55pm
+    Author:  Christopher Duvall
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ What the drone sounds like and what it's doing, sent from the audio thread to the editor.
+
+ Two lock-free single producer / single consumer rings (juce::AbstractFifo), audio thread in, message thread out:
+ the output mixed to mono and decimated (scope and spectrum), and a State a few dozen times a second
+ (partials, gain LFO's, filter, chase). The audio thread only copies into memory that's already there,
+ a full ring drops what doesn't fit and carries on, it never waits for the editor.
+
+ Off until setActive(true) (the editor opening), push calls cost the processor a single atomic load until then.
+*/
+
+class Telemetry
+{
+public:
+    static constexpr int maxVoices = 64; // ThickSynth's biggest voice pool
+
+    struct State
+    {
+        juce::int64 time = 0; // samples into the piece
+        int oscCount = 0; // thick synth partials sounding
+        float vectorFreq = 0.0f; // thick synth base frequency
+        float cutoff = 0.0f; // thick synth filter
+        float resonance = 0.0f;
+        float chaseFreq = 0.0f; // where the chase synth is
+        float chaseTarget = 0.0f; // where it's going
+        float chasePan = 0.0f; // 1 = left, 0 = right
+        float gainLFOFreqs[maxVoices] = {}; // first oscCount are the sounding partials
+    };
+
+    static constexpr int decimation = 2; // scope and spectrum run at half the sample rate
+    static constexpr int sampleCapacity = 1 << 15; // decimated samples queued, over a second at 48 kHz
+    static constexpr int stateCapacity = 16; // States queued
+    static constexpr int stateRateHz = 30; // States per second, about the editor's frame rate
+
+    // -------- SETTERS -------- //
+
+    // sample rate, from prepareToPlay, never while processBlock is running
+    void prepare(double SR)
+    {
+        sampleRate.store(SR);
+        stateInterval = juce::jmax(1, (int)(SR / stateRateHz));
+        samplesToState = 0;
+        decimationPhase = 0;
+        decimationSum = 0.0f;
+    }
+
+    // message thread, the editor turns it on while it's open
+    void setActive(bool shouldBeActive)
+    {
+        // nothing's being pushed while it's off, clear out whatever's left from last time
+        if (shouldBeActive && ! isActive())
+        {
+            skip(sampleRing);
+            skip(stateRing);
+            dropped.store(0);
+        }
+
+        active.store(shouldBeActive, std::memory_order_release);
+    }
+
+    // -------- AUDIO THREAD -------- //
+    bool isActive()
+    {
+        return active.load(std::memory_order_acquire);
+    }
+
+    // output, left and right averaged (right can be nullptr for mono), every decimation samples averaged into one
+    void pushSamples(const float* left, const float* right, int numSamples)
+    {
+        if (! isActive())
+            return;
+
+        int start1, size1, start2, size2;
+        sampleRing.prepareToWrite((decimationPhase + numSamples) / decimation, start1, size1, start2, size2);
+
+        float gain = (right != nullptr ? 0.5f : 1.0f) / (float)decimation;
+        int written = 0;
+
+        for (int i = 0; i < numSamples; i++)
+        {
+            decimationSum += right != nullptr ? left[i] + right[i] : left[i];
+
+            if (++decimationPhase < decimation)
+                continue;
+
+            float value = decimationSum * gain;
+            decimationSum = 0.0f;
+            decimationPhase = 0;
+
+            if (written < size1)
+                samples[start1 + written] = value;
+            else if (written - size1 < size2)
+                samples[start2 + written - size1] = value;
+            else
+                dropped.fetch_add(1, std::memory_order_relaxed);
+
+            written++;
+        }
+
+        sampleRing.finishedWrite(juce::jmin(written, size1 + size2));
+    }
+
+    // true when a State is due in this block, counts the block off either way
+    bool stateDue(int numSamples)
+    {
+        if (! isActive())
+            return false;
+
+        samplesToState -= numSamples;
+
+        if (samplesToState > 0)
+            return false;
+
+        samplesToState += stateInterval;
+        samplesToState = juce::jmax(1, samplesToState); // blocks longer than the interval send one per block
+        return true;
+    }
+
+    void pushState(const State& state)
+    {
+        int start1, size1, start2, size2;
+        stateRing.prepareToWrite(1, start1, size1, start2, size2);
+
+        if (size1 + size2 == 0)
+            return; // editor's behind, it only wants the latest anyway
+
+        states[size1 > 0 ? start1 : start2] = state;
+        stateRing.finishedWrite(1);
+    }
+
+    // -------- MESSAGE THREAD -------- //
+
+    // oldest queued samples first, returns how many were copied
+    int readSamples(float* dest, int maxSamples)
+    {
+        int start1, size1, start2, size2;
+        sampleRing.prepareToRead(maxSamples, start1, size1, start2, size2);
+
+        std::copy(samples + start1, samples + start1 + size1, dest);
+        std::copy(samples + start2, samples + start2 + size2, dest + size1);
+
+        sampleRing.finishedRead(size1 + size2);
+        return size1 + size2;
+    }
+
+    // newest State, false if nothing new came since the last call
+    bool readState(State& dest)
+    {
+        int start1, size1, start2, size2;
+        stateRing.prepareToRead(stateCapacity, start1, size1, start2, size2);
+
+        if (size1 + size2 == 0)
+            return false;
+
+        dest = size2 > 0 ? states[start2 + size2 - 1] : states[start1 + size1 - 1];
+        stateRing.finishedRead(size1 + size2);
+        return true;
+    }
+
+    double getScopeSampleRate()
+    {
+        return sampleRate.load() / decimation;
+    }
+
+    juce::uint32 getDroppedSamples() // didn't fit since the editor opened (it fell behind)
+    {
+        return dropped.load(std::memory_order_relaxed);
+    }
+
+private:
+    static void skip(juce::AbstractFifo& ring) // reader side, throws away everything queued
+    {
+        ring.finishedRead(ring.getNumReady());
+    }
+
+    juce::AbstractFifo sampleRing { sampleCapacity };
+    juce::AbstractFifo stateRing { stateCapacity };
+    float samples[sampleCapacity];
+    State states[stateCapacity];
+
+    std::atomic<bool> active { false };
+    std::atomic<double> sampleRate { 44100.0 };
+    std::atomic<juce::uint32> dropped { 0 };
+
+    // audio thread only
+    int stateInterval = 1470; // samples between States
+    int samplesToState = 0;
+    int decimationPhase = 0;
+    float decimationSum = 0.0f;
+};
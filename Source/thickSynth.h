@@ -11,11 +11,15 @@
 #pragma once
 
 #include <JuceHeader.h>
-#include "PluginProcessor.h"
 #include "osc.h"
+#include "oscBank.h"
+#include "modNoise.h"
+#include "eventScheduler.h"
+#include "eventLog.h"
 
 /**
  The heart of this class is a vector of oscillators, with alternating wave types.
+ Both vectors are OscillatorBanks, so every partial and gain LFO is rendered a SIMD register at a time.
  Provides the low frequencies and the main substance of the drone.
  
  A vector of LFO's to control gain creates interesting beating frequencies with amplitude modulation
@@ -24,6 +28,21 @@
  Filter cutoff and resonance controlled by LFO's.
  
  oscCount is amount of elements in vectors at any given time.
+ Both banks are preallocated for maxOscCount voices in prepare() (called from prepareToPlay, as often as the host likes).
+ prepare() only reallocates when the pool size changes, and a piece that's already playing carries on at the new sample rate.
+ reset() starts the piece over from the seeds without allocating.
+ Adding or removing an element fades a pooled voice in or out, nothing is allocated on the audio thread.
+ 
+ Gain LFO changes (every gainChangeSeconds) and vector size changes (every sizeChangeSeconds) are events
+ on an EventScheduler. Blocks are split at the exact sample they're due, nothing is checked in between.
+ 
+ Rendered a block at a time. LFO's only update every controlRate samples,
+ the per sample path is just frequency modulation and the oscillator banks.
+ Frequency modulation noise comes a block at a time from ModNoise and goes straight into the bank as phase deltas.
+ 
+ vectorFreq (the pitch of the whole drone) glides to setVectorFreq() over freqGlideSeconds, a control tick at a time.
+ 
+ skipBlock() runs the piece forward at control rate without making any sound, for seeking.
 */
 
 class ThickSynth : Oscillator
@@ -35,7 +54,47 @@ public:
     {
         lfo1.setSampleRate(SR);
         lfo2.setSampleRate(SR);
-        counterMax = (int)SR;
+        lfo1.setSineMode(SineMode::poly7); // -116 dB is plenty for modulation
+        lfo2.setSineMode(SineMode::poly7);
+        sampleRate = SR;
+    }
+    
+    void setControlRate(int rate) // samples between LFO updates, call before prepare
+    {
+        controlRate = juce::jmax(1, rate);
+        samplesToControl = 0;
+    }
+    
+    void setSeed(juce::int64 seed) // seed for randommm, see RandomSource, reset() starts from it again
+    {
+        pieceSeed = seed;
+        randommm.setSeed(seed);
+    }
+    
+    void setNoiseSeed(juce::int64 seed) // seed for frequency modulation noise
+    {
+        fmNoise.setSeed(seed);
+    }
+    
+    void setFMNoise(float rate, float smoothing) // new noise values per second (0 = every sample), glide time in seconds
+    {
+        fmNoiseRate = rate;
+        fmNoiseSmoothing = smoothing;
+        fmNoise.setRate(rate);
+        fmNoise.setSmoothing(smoothing);
+    }
+    
+    void setEventTimes(float gainSeconds, float sizeSeconds) // time between gain LFO changes and vector size changes, from the next change on
+    {
+        jassert(gainSeconds > 0.0f && sizeSeconds > 0.0f); // anything shorter than a sample gets a sample, see secondsToSamples
+        
+        gainChangeSeconds = gainSeconds;
+        sizeChangeSeconds = sizeSeconds;
+    }
+    
+    void setMaxOscCount(int max) // voice pool size, takes effect at next prepare (which starts the piece over)
+    {
+        maxOscCount = juce::jlimit(minOscCount, maxPoolSize, max);
     }
     
     void setLFOFrequencies() // frequencies (fixed)
@@ -43,6 +102,23 @@ public:
         lfo1.setFreq(lfoFreq1);
         lfo2.setFreq(lfoFreq2);
     }
+    
+    void setLFOFrequencies(float freq1, float freq2) // filter cutoff LFO, resonance / frequency modulation LFO, phases carry on
+    {
+        lfoFreq1 = freq1;
+        lfoFreq2 = freq2;
+        setLFOFrequencies();
+    }
+    
+    void setEventLog(EventLog* newLog) // where gain LFO and partial count changes get traced, nullptr for nowhere
+    {
+        eventLog = newLog;
+    }
+    
+    void setVectorFreq(float freq) // base frequency of every partial, glides there, jumps at prepare
+    {
+        smoothFreq.setTargetValue(freq);
+    }
 
     void setCutoff(float CO) // filter cutoff
     {
@@ -57,6 +133,7 @@ public:
     void setVectorVol() // dynamically scaling oscillator vector gain
     {
         vectorVol = 0.9 / (float)oscCount;
+        smoothVol.setTargetValue(vectorVol); // glides with the voice fades
     }
     
     // -------- GETTERS -------- //
@@ -70,175 +147,593 @@ public:
         return resMod;
     }
     
+    int getOscCount() // partials sounding (not counting any fading out)
+    {
+        return oscCount;
+    }
+    
+    float getVectorFreq() // base frequency of every partial, where the glide is now
+    {
+        return vectorFreq;
+    }
+    
+    float getGainLFOFreq(int voice) // how fast a partial swells, see handleEvent
+    {
+        return gainVector.getFreq(voice);
+    }
+    
+    // -------- STATE -------- //
+    
+    // everything the drone has grown into (vector size, gain LFO's, random numbers, time to the next changes),
+    // so a saved session carries on from the same place
+    juce::ValueTree getState()
+    {
+        juce::ValueTree state ("thickSynth");
+        state.setProperty("oscCount", oscCount, nullptr);
+        state.setProperty("up", up, nullptr);
+        state.setProperty("gainMax", gainMax, nullptr);
+        state.setProperty("random", randommm.getSeed(), nullptr);
+        state.setProperty("lfo1Phase", lfo1.getPhase(), nullptr);
+        state.setProperty("lfo2Phase", lfo2.getPhase(), nullptr);
+        state.setProperty("gainChangeIn", scheduler.samplesUntil(gainChangeEvent), nullptr);
+        state.setProperty("sizeChangeIn", scheduler.samplesUntil(sizeChangeEvent), nullptr);
+        
+        for (int i = 0; i < oscCount; i++)
+        {
+            juce::ValueTree voice ("voice");
+            voice.setProperty("phase", oscVector.getPhase(i), nullptr);
+            voice.setProperty("gainFreq", gainVector.getFreq(i), nullptr);
+            voice.setProperty("gainPhase", gainVector.getPhase(i), nullptr);
+            state.appendChild(voice, nullptr);
+        }
+        
+        return state;
+    }
+    
+    // back to a getState(), call after prepare
+    void setState(const juce::ValueTree& state)
+    {
+        if (! state.hasType("thickSynth"))
+            return;
+        
+        oscCount = juce::jlimit(1, maxOscCount, (int)state["oscCount"]);
+        up = state["up"];
+        gainMax = state["gainMax"];
+        randommm.setSeed((juce::int64)state["random"]);
+        lfo1.setPhase(state["lfo1Phase"]);
+        lfo2.setPhase(state["lfo2Phase"]);
+        
+        // straight to the saved vector size, no fades
+        for (int i = 0; i < oscVector.getCapacity(); i++)
+        {
+            if (i < oscCount)
+            {
+                oscVector.activate(i, 0);
+                oscVector.setFreq(i, vectorFreq * (i + 1));
+                oscVector.setPulseWidth(i, vectorPW);
+            }
+            else
+                oscVector.deactivate(i, 0);
+        }
+        
+        for (int i = 0; i < oscCount && i < state.getNumChildren(); i++)
+        {
+            auto voice = state.getChild(i);
+            oscVector.setPhase(i, voice["phase"]);
+            gainVector.setFreq(i, voice["gainFreq"]);
+            gainVector.setPhase(i, voice["gainPhase"]);
+        }
+        
+        renderCount = oscCount;
+        setVectorVol();
+        smoothVol.setCurrentAndTargetValue(vectorVol);
+        
+        scheduler.reset();
+        scheduler.scheduleIn(gainChangeEvent, state.getProperty("gainChangeIn", secondsToSamples(gainChangeSeconds)));
+        scheduler.scheduleIn(sizeChangeEvent, state.getProperty("sizeChangeIn", secondsToSamples(sizeChangeSeconds)));
+        samplesToControl = 0;
+    }
+    
+    // -------- SNAPSHOT -------- //
+    
+    // getState() bit for bit, plus every voice, noise lane and glide, see snapshot.h
+    // reads back into a synth set up with the same sample rate, control rate and pool size
+    void writeSnapshot(SnapshotWriter& writer)
+    {
+        writer.write(randommm.getSeed());
+        lfo1.writeSnapshot(writer);
+        lfo2.writeSnapshot(writer);
+        oscVector.writeSnapshot(writer);
+        gainVector.writeSnapshot(writer);
+        writer.writeArray(baseDelta, maxPoolSize);
+        fmNoise.writeSnapshot(writer);
+        scheduler.writeSnapshot(writer);
+        writer.write(oscCount);
+        writer.write(renderCount);
+        writer.write(vectorVol);
+        writer.writeSmoothed(smoothVol);
+        writer.write(vectorFreq);
+        writer.writeSmoothed(smoothFreq);
+        writer.write(lfo2Val);
+        writer.write(samplesToControl);
+        writer.write(gainMax);
+        writer.write(up);
+        writer.write(cutoff);
+        writer.write(resMod);
+    }
+    
+    void readSnapshot(SnapshotReader& reader)
+    {
+        juce::int64 seed = randommm.getSeed();
+        reader.read(seed);
+        randommm.setSeed(seed);
+        
+        lfo1.readSnapshot(reader);
+        lfo2.readSnapshot(reader);
+        oscVector.readSnapshot(reader);
+        gainVector.readSnapshot(reader);
+        reader.readArray(baseDelta, maxPoolSize);
+        fmNoise.readSnapshot(reader);
+        scheduler.readSnapshot(reader);
+        reader.read(oscCount);
+        reader.read(renderCount);
+        reader.read(vectorVol);
+        reader.readSmoothed(smoothVol);
+        reader.read(vectorFreq);
+        reader.readSmoothed(smoothFreq);
+        reader.read(lfo2Val);
+        reader.read(samplesToControl);
+        reader.read(gainMax);
+        reader.read(up);
+        reader.read(cutoff);
+        reader.read(resMod);
+    }
+    
     // -------- METHODS -------- //
     
-    // initialize vectors
+    // sample rate, control rate and voice pools, never call from the audio thread
+    // can be called again any time the synth isn't rendering: the pools are only reallocated (and the piece started over)
+    // when maxOscCount changed, otherwise everything carries on at the new rate, same pitches, same time to the next event
+    void prepare(double SR, int rate)
+    {
+        double previousRate = sampleRate;
+        
+        setAllSampleRate(SR); // LFO's keep their frequencies
+        
+        if (rate != controlRate)
+            setControlRate(rate);
+        
+        // voice pools, only reallocated if maxOscCount changed
+        bool newPool = maxOscCount != preparedPoolSize;
+        preparedPoolSize = maxOscCount;
+        oscVector.setCapacity(maxOscCount);
+        gainVector.setCapacity(maxOscCount);
+        
+        oscVector.setSampleRate(SR);
+        gainVector.setSampleRate(SR);
+        
+        // one noise lane per partial, a control period at a time
+        fmNoise.prepare(SR, maxOscCount, controlRate);
+        
+        voiceRamp = (int)(SR * voiceRampSeconds);
+        smoothVol.reset(SR, voiceRampSeconds);
+        
+        // pitch glides a control tick at a time, jumps to the latest setVectorFreq()
+        smoothFreq.reset(SR / controlRate, freqGlideSeconds);
+        vectorFreq = smoothFreq.getCurrentValue();
+        
+        // without logging, owners seed and reset() straight after (see startPiece), one set of start events is plenty
+        if (newPool)
+        {
+            auto* log = eventLog;
+            eventLog = nullptr;
+            reset();
+            eventLog = log;
+            return;
+        }
+        
+        // carrying on, the next events are still the same number of seconds away
+        updateBaseDeltas();
+        scheduler.rescale(SR / previousRate);
+    }
+    
+    // back to the start of the piece, from the seeds (setSeed() and setNoiseSeed() first for a different piece)
+    // never allocates, call after prepare, whenever the synth isn't rendering
     // oscVector is sounding vector
     // gainVector creates procedurally generated beating amplitude modilation
-    void initVector(double _SR)
+    void reset()
     {
+        randommm.setSeed(pieceSeed); // same piece every time
+        oscCount = minOscCount;
+        renderCount = oscCount;
+        up = true;
+        gainMax = 2;
+        
+        setVectorVol();
+        smoothVol.setCurrentAndTargetValue(vectorVol);
+        smoothFreq.setCurrentAndTargetValue(smoothFreq.getTargetValue());
+        vectorFreq = smoothFreq.getCurrentValue();
+        
+        lfo1.resetPhase();
+        lfo2.resetPhase();
+        lfo2Val = 0.0f;
+        samplesToControl = 0;
+        skippedSamples = 0;
+        skippedMod = 0.0;
+        
+        fmNoise.reset();
+        
+        // wave type and level of every possible partial, alternating square, sine, triangle
+        for (int i = 0; i < oscVector.getCapacity(); i++)
+        {
+            // although frequencies are randomized, they are generated in clean ratios to each other
+            if (i % 3 == 0)
+            {
+                oscVector.setWaveType(i, OscillatorBank::square);
+                voiceVol[i] = 0.5f;
+                voiceRatio[i] = i + 0.4f;
+            }
+            else if (i % 3 == 1)
+            {
+                oscVector.setWaveType(i, OscillatorBank::sine);
+                voiceVol[i] = 1.2f;
+                voiceRatio[i] = i + 1.2f;
+            }
+            else
+            {
+                oscVector.setWaveType(i, OscillatorBank::triangle);
+                voiceVol[i] = 1.0f;
+                voiceRatio[i] = i + 1.8f;
+            }
+            
+            oscVector.setBandLimited(i, true); // PolyBLEP, high partials don't alias
+            
+            gainVector.setWaveType(i, OscillatorBank::sine); // gain LFO's are all sine waves
+            gainVector.activate(i, 0); // gain LFO's are always on, oscVector levels decide what's heard
+            gainVector.resetPhase(i);
+            
+            oscVector.deactivate(i, 0); // everything starts silent
+            oscVector.resetPhase(i);
+        }
+        
+        updateBaseDeltas();
+        
         // init sounding oscillator vector
         for (int i = 0; i < oscCount; i++)
         {
-            oscVector.push_back(Oscillator());
-            oscVector[i].setSampleRate(_SR);
-            oscVector[i].setPulseWidth(vectorPW);
-            oscVector[i].setFreq(vectorFreq * (i + 1));
+            oscVector.activate(i, 0);
+            oscVector.setPulseWidth(i, vectorPW);
+            oscVector.setFreq(i, vectorFreq * (i + 1));
         }
         
+        renderCount = oscCount;
+        
         // init gain oscillator
         for (int i = 0; i < oscCount; i++)
         {
-            gainVector.push_back(Oscillator());
-            gainVector[i].setSampleRate(_SR);
             float test = randommm.nextFloat() * (i + randommm.nextFloat());
-            gainVector[i].setFreq( test );
-            std::cout << i << "'s gain is: " << test << "\n";
+            gainVector.setFreq(i, test);
+            trace(EventLog::gainLFOChanged, 0, (float)i, test);
         }
+        
+        // first structural changes
+        scheduler.reset();
+        scheduler.scheduleIn(gainChangeEvent, secondsToSamples(gainChangeSeconds));
+        scheduler.scheduleIn(sizeChangeEvent, secondsToSamples(sizeChangeSeconds));
     }
     
     // Amplitude modulation dynamically created here
     // Each LFO element in vector has a different frequency
-    // counter1 keeps track of frequencies, counter2 keeps track of number of elements in vector
-    float vectorGain(int iterator)
+    // gain change events re-randomize one gain LFO, size change events add or remove an element
+    // called by the scheduler at the exact sample an event is due, then schedules the next one
+    void handleEvent(int id)
     {
-        // iterate counters
-        counter1++; // frequencies
-        counter2++; // amount of elements in vectors
-        
-        // keep track of incrementing or decrementing amounts of elements in vectors
-        if (oscCount == 11)
-            up = false; // up == false means going down
-        if (oscCount == 3 && up == false)
-            up = true; // up == true means going up (INITIAL SETTING)
-        
-        // randomly give one gain vector element a different frequency
-        if (counter1 == counterMax * 30 )
+        if (id == gainChangeEvent)
         {
+            // randomly give one gain vector element a different frequency
             int next = randommm.nextInt(oscCount); // pick a random element
             
             // create random gain frequency
             float nextGain = randommm.nextInt(gainMax) * (randommm.nextFloat() + 0.1);
             
-            gainVector[next].setFreq(nextGain); // implement changes
-            counter1 = 0; // reset counter
+            gainVector.setFreq(next, nextGain); // implement changes
             gainMax += 2; // increase frequency maximum, increase potential entropy
+            trace(EventLog::gainLFOChanged, scheduler.getTime(), (float)next, nextGain);
+            
+            scheduler.scheduleIn(gainChangeEvent, secondsToSamples(gainChangeSeconds));
         }
-        
-        // linearly create vector elements (both vectors)
-        if (counter2 == counterMax * 70 && up == true) // going up
-        {
-            addElement(counterMax);
-            counter2 = 0;
-        }
-        else if (counter2 == counterMax * 70 && up == false) // going down
+        else if (id == sizeChangeEvent)
         {
-            removeElement();
-            counter2 = 0;
+            // keep track of incrementing or decrementing amounts of elements in vectors
+            if (oscCount >= maxOscCount)
+                up = false; // up == false means going down
+            if (oscCount <= minOscCount && up == false)
+                up = true; // up == true means going up (INITIAL SETTING)
+            
+            // linearly create vector elements (both vectors)
+            if (up == true) // going up
+                addElement();
+            else // going down
+                removeElement();
+            
+            scheduler.scheduleIn(sizeChangeEvent, secondsToSamples(sizeChangeSeconds));
         }
-        
-        float gain = gainVector[iterator].sineWave(); // keep vector elements' gain in check
-        
-        return gain;
     }
     
     // increase the amount of vector elements in both vectors
-    void addElement(int SR)
+    // fades in the next voice from the pool
+    void addElement()
     {
+        if (oscCount >= maxOscCount) // pool is full
+            return;
+        
         oscCount++; // iterate osc count
         
         setVectorVol(); // balance volume across all oscillators
         
-        // push new elements into vectors
-        oscVector.push_back(Oscillator());
-        gainVector.push_back(Oscillator());
+        // set up new gain LFO in vector (fresh phase, unless still fading out)
+        if (! oscVector.isActive(oscCount - 1))
+            gainVector.resetPhase(oscCount - 1);
+        gainVector.setFreq(oscCount - 1, randommm.nextFloat() * ((oscCount - 1) + randommm.nextFloat()));
         
         // set up new sounding oscillator in vector
-        oscVector[oscCount - 1].setSampleRate((float)SR);
-        oscVector[oscCount - 1].setFreq(vectorFreq * oscCount);
-        oscVector[oscCount - 1].setPulseWidth(vectorPW);
+        oscVector.activate(oscCount - 1, voiceRamp);
+        oscVector.setFreq(oscCount - 1, vectorFreq * oscCount);
+        oscVector.setPulseWidth(oscCount - 1, vectorPW);
         
-        // set up new gain LFO in vector
-        gainVector[oscCount - 1].setSampleRate(SR);
-        gainVector[oscCount - 1].setFreq(randommm.nextFloat() * ((oscCount - 1) + randommm.nextFloat()));
+        renderCount = juce::jmax(renderCount, oscCount);
+        trace(EventLog::partialAdded, scheduler.getTime(), (float)oscCount);
     }
     
     // decrement vector elemtns
+    // fades out the top voice, it keeps rendering until silent
     void removeElement()
     {
+        if (oscCount <= 1)
+            return;
+        
         oscCount--; // regulate top-level vector element variable
         setVectorVol(); // regulate oscillator gain
-        oscVector.pop_back();
-        gainVector.pop_back();
+        oscVector.deactivate(oscCount, voiceRamp);
+        trace(EventLog::partialRemoved, scheduler.getTime(), (float)oscCount);
     }
 
     // -------- PROCESS -------- //
     // steps through filter LFO'ed params
-    // steps through oscVector frequency modulations
-    // outputs sample to top level program
-    float process(double _SR)
-    {   
+    // once every controlRate samples
+    void controlTick()
+    {
+        // lfo1 moves once per sample
+        lfo1.skip(controlRate - 1);
         setCutoff(lfo1.sineWave() * 1200.0 + 1850.0 ); // filter cutoff
-        setResMod(lfo2.sineWave() + 1.0 * 5.0 ); // filter resonance
         
+        // lfo2 moves once per sample plus once per partial (resonance and frequency modulation)
+        lfo2.skip((oscCount + 1) * controlRate - 1);
+        lfo2Val = lfo2.sineWave();
+        setResMod(lfo2Val + 1.0 * 5.0 ); // filter resonance
+        
+
+        // stop rendering voices that have finished fading out
+        while (renderCount > oscCount && ! oscVector.isActive(renderCount - 1))
+            renderCount--;
+        
+        // pitch glide
+        if (smoothFreq.isSmoothing())
+        {
+            vectorFreq = smoothFreq.getNextValue();
+            updateBaseDeltas();
+        }
+    }
+    
+    // steps through oscVector frequency modulations
+    // noise holds one modulation value per partial for this sample
+    // outputs one pre-filter sample
+    float renderSample(const float* noise)
+    {
         float raw = 0.0f; // starter sample
+        float lfoMod = lfo2Val + 1.1f;
 
-        // regulate oscVector (sounding oscillator vector)
-        for (int j = 0; j < oscCount; j++)
+        // regulate oscVector (sounding oscillator vector), including voices still fading out
+        // frequency modulation amount is lfo2 + noise, applied straight to phase deltas
+        for (int j = 0; j < renderCount; j++)
+            fmDelta[j] = baseDelta[j] * (lfoMod + noise[j]);
+        
+        oscVector.setPhaseDeltas(fmDelta, renderCount);
+        
+        // render every partial and gain LFO at once
+        const float* oscOut = oscVector.process(renderCount);
+        const float* gainOut = gainVector.process(renderCount);
+        const float* levels = oscVector.getLevels();
+        
+        float vol = smoothVol.getNextValue();
+        
+        // each gain scales everything summed before it (volume regulation)
+        // a fading voice's gain fades towards 1 with it, so it drops out of the chain smoothly
+        for (int j = 0; j < renderCount; j++)
+            raw = (raw + oscOut[j] * vol * voiceVol[j]) * (1.0f + levels[j] * (gainOut[j] - 1.0f));
+        
+        return raw;
+    }
+    
+    // outputs a block of pre-filter samples to top level program
+    // cutoffs and resonances receive the filter settings for every sample
+    void renderBlock(float* out, float* cutoffs, float* resonances, int numSamples)
+    {
+        int done = 0;
+        
+        while (done < numSamples)
         {
-            // frequency modulation amount
-            float mod = (lfo2.sineWave() + randommm.nextFloat() + 1.1) ;
+            // structural changes due at this sample
+            int eventId;
+            while (scheduler.popDueEvent(eventId))
+                handleEvent(eventId);
             
-            // three different kinds of wave types in this vector
-            // although frequencies are randomized, they are generated in clean ratios to each other
-            if (j % 3 == 0)
+            if (samplesToControl == 0)
             {
-                oscVector[j].setFreq(vectorFreq * (j + 0.4 ) * mod);
-                raw += oscVector[j].squareWave() * vectorVol * 0.5;
+                controlTick();
+                samplesToControl = controlRate;
             }
-            else if (j % 3 == 1)
+            
+            // render up to the next control tick or event, whichever comes first
+            int run = scheduler.samplesUntilNextEvent(juce::jmin(numSamples - done, samplesToControl));
+            
+            // frequency modulation noise for the whole run
+            const float* noise = fmNoise.process(run);
+            int noiseStride = fmNoise.getNumLanes();
+            
+            for (int i = done; i < done + run; i++)
             {
-                oscVector[j].setFreq(vectorFreq * (j + 1.2) * mod);
-                raw += oscVector[j].sineWave() * vectorVol * 1.2;
+                out[i] = renderSample(noise + (i - done) * noiseStride);
+                cutoffs[i] = cutoff;
+                resonances[i] = resMod;
             }
-            else
+            
+            done += run;
+            samplesToControl -= run;
+            scheduler.advance(run);
+        }
+    }
+    
+    // -------- SEEKING -------- //
+    // renderBlock() without the audio, for jumping ahead in the piece
+    // events, control ticks, random numbers and glides happen exactly as they would, cutoffs and resonances are filled the same,
+    // the oscillators just jump ahead at their average frequency over the block (see flushSkip())
+    void skipBlock(float* cutoffs, float* resonances, int numSamples)
+    {
+        int done = 0;
+        
+        while (done < numSamples)
+        {
+            int eventId;
+            while (scheduler.popDueEvent(eventId))
             {
-                oscVector[j].setFreq(vectorFreq * (j + 1.8) * mod);
-                raw += oscVector[j].triWave() * vectorVol;
+                flushSkip(); // events fade voices in and out, ramps have to be up to date
+                handleEvent(eventId);
             }
             
-            raw *= vectorGain((j)); // volume regulation
+            if (samplesToControl == 0)
+            {
+                controlTick();
+                samplesToControl = controlRate;
+            }
+            
+            int run = scheduler.samplesUntilNextEvent(juce::jmin(numSamples - done, samplesToControl));
+            
+            std::fill(cutoffs + done, cutoffs + done + run, cutoff);
+            std::fill(resonances + done, resonances + done + run, resMod);
+            
+            // frequency modulation over the run, noise averages 0.5
+            skippedSamples += run;
+            skippedMod += (lfo2Val + 1.1f + 0.5f) * (double)run;
+            
+            done += run;
+            samplesToControl -= run;
+            scheduler.advance(run);
         }
         
-        return raw;
+        flushSkip();
     }
     
 private:
+    // catches the oscillators and noise up with skipBlock()
+    void flushSkip()
+    {
+        if (skippedSamples == 0)
+            return;
+        
+        float mod = (float)(skippedMod / skippedSamples);
+        
+        for (int j = 0; j < renderCount; j++)
+            fmDelta[j] = baseDelta[j] * mod;
+        
+        oscVector.setPhaseDeltas(fmDelta, renderCount);
+        oscVector.skip(renderCount, skippedSamples);
+        gainVector.skip(renderCount, skippedSamples);
+        fmNoise.skip(skippedSamples);
+        smoothVol.skip(skippedSamples);
+        
+        skippedSamples = 0;
+        skippedMod = 0.0;
+    }
+    
+    void trace(EventLog::Type type, juce::int64 time, float value1, float value2 = 0.0f)
+    {
+        if (eventLog != nullptr)
+            eventLog->push(type, time, value1, value2);
+    }
+    
+    // event intervals, at least 1 sample: renderBlock stops at every event, an event due every 0 samples would never let it finish
+    juce::int64 secondsToSamples(float seconds)
+    {
+        return juce::jmax((juce::int64)1, (juce::int64)(seconds * sampleRate));
+    }
+    
+    void updateBaseDeltas() // phase delta of every partial before modulation, follows vectorFreq
+    {
+        for (int i = 0; i < oscVector.getCapacity(); i++)
+            baseDelta[i] = vectorFreq * voiceRatio[i] / (float)sampleRate;
+    }
+    
     // init lfos
     Oscillator lfo1;
     Oscillator lfo2;
     
     //init sounding oscillator and gain LFO vectors
-    std::vector<Oscillator> oscVector;
-    std::vector<Oscillator> gainVector;
+    OscillatorBank oscVector;
+    OscillatorBank gainVector;
+    
+    // level and frequency ratio (to vectorFreq) of each partial, sized to fit any pool
+    static constexpr int maxPoolSize = 64;
+    float voiceVol[maxPoolSize];
+    float voiceRatio[maxPoolSize];
+    float baseDelta[maxPoolSize]; // vectorFreq * voiceRatio / sample rate
+    float fmDelta[maxPoolSize]; // modulated phase deltas, rebuilt every sample
+    
+    // frequency modulation noise, one lane per partial
+    ModNoise fmNoise;
+    float fmNoiseRate = 0.0f; // new values per second, 0 = every sample (original white noise FM)
+    float fmNoiseSmoothing = 0.0f; // seconds
     
     // init sounding oscillator variables
     int oscCount = 3; // top-level oscillator regulation amount
+    int minOscCount = 3; // vector turns around here going down
+    int maxOscCount = 11; // voice pool size, vector turns around here going up
+    int preparedPoolSize = 0; // maxOscCount the pools were last prepared for
+    int renderCount = 3; // voices being rendered, oscCount plus any still fading out
+    int voiceRamp = 0; // samples to fade a voice in or out
+    float voiceRampSeconds = 0.02f;
     float vectorVol = 0.9 / (float)oscCount; // sounding oscillator gain regulator
+    juce::SmoothedValue<float> smoothVol; // vectorVol, gliding when vector size changes
     float vectorFreq = 45.0f; // starting vector frequency
+    juce::SmoothedValue<float> smoothFreq { vectorFreq }; // vectorFreq, gliding to setVectorFreq()
+    float freqGlideSeconds = 2.0f;
     float vectorPW = 0.4f; // square wave pulse width
     
     // init LFO variables
     float lfoFreq1 = .0612f; // mostly for filter cutoff modulation
     float lfoFreq2 = 0.005f; // filter resonance modulation and oscVector frequency modulation
-    int counterMax; // integer version of sample rate, used for timing
-    int counter1 = 0; // frequencies
-    int counter2 = 0; // amount of elements in vectors
+    float lfo2Val = 0.0f; // lfo2 at last control tick
+    int controlRate = 32; // samples between LFO updates
+    int samplesToControl = 0; // countdown to next control tick
+    double sampleRate = 44100.0;
     int gainMax = 2; // initial frequency maximum
     
+    // structural changes, scheduled in samples
+    enum Events { gainChangeEvent = 0, sizeChangeEvent };
+    EventScheduler scheduler;
+    float gainChangeSeconds = 30.0f; // new frequency for one gain LFO
+    float sizeChangeSeconds = 70.0f; // add or remove one element
+    
     bool up = true; // incrementing or decrementing vector elements
     
+    // skipBlock() samples the oscillators haven't caught up with yet, and their total frequency modulation
+    int skippedSamples = 0;
+    double skippedMod = 0.0;
+    
     juce::Random randommm; // juce random object
+    juce::int64 pieceSeed = 1; // where randommm starts at reset()
+    
+    EventLog* eventLog = nullptr; // trace of structural changes, see setEventLog
     
     //init filter variables
     float cutoff;